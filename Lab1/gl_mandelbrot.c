@@ -64,7 +64,7 @@ typedef struct position position_t;
 struct ppm* ppm;
 struct mandelbrot_param draw_param;
 
-int mouse_button_0, mouse_button_1, bounce, print_help;
+int mouse_button_0, mouse_button_1, bounce, print_help, adaptive;
 double scale, speed;
 coord_t mouse_grab;
 
@@ -326,6 +326,15 @@ draw()
 		exit(-1);
 	}
 
+	// Choose the iteration budget to keep up with the animation
+	if (adaptive)
+	{
+		int maxiter = draw_param.maxiter;
+
+		if (adapt_maxiter(&draw_param, REFRESH_FREQ / 1000.0) != maxiter)
+			update_colors(&draw_param);
+	}
+
 	const double startTime = WallClockTime();
 	compute_mandelbrot(draw_param);
 
@@ -339,8 +348,8 @@ draw()
 	glColor3f(1.f, 1.f, 1.f);
 	glRasterPos2i(4, 10);
 	sprintf(perf_caption,
-	    "Rendering time: %.3f secs (sample/sec: %.1fK; max iterations: %d)",
-	    elapsedTime, sampleSec / 1000.f, draw_param.maxiter);
+	    "Rendering time: %.3f secs (sample/sec: %.1fK; max iterations: %d%s)",
+	    elapsedTime, sampleSec / 1000.f, draw_param.maxiter, adaptive ? ", adaptive" : "");
 	print_str(GLUT_BITMAP_HELVETICA_18, perf_caption);
 
 	glRasterPos2i(4, draw_param.height - 20);
@@ -379,6 +388,8 @@ draw()
 		print_str(GLUT_BITMAP_HELVETICA_18, "- - Decrease max. iterations by 32");
 		glRasterPos2i(60, 180);
 		print_str(GLUT_BITMAP_HELVETICA_18, "b - Enable/disable bouncing");
+		glRasterPos2i(60, 150);
+		print_str(GLUT_BITMAP_HELVETICA_18, "a - Enable/disable adaptive max. iterations");
 
 		glDisable(GL_BLEND);
 
@@ -540,11 +551,16 @@ keyboard_key(unsigned char key, int x, int y)
 	case 'Q':
 		exit(0);
 		break;
+	case 'a':
+		adaptive = !adaptive;
+		break;
 	case '+':
+		adaptive = 0;
 		draw_param.maxiter += draw_param.maxiter < 1024 - 32 ? 32 : 0;
 		update_colors(&draw_param);
 		break;
 	case '-':
+		adaptive = 0;
 		draw_param.maxiter -= draw_param.maxiter > 0 + 32 ? 32 : 0;
 		update_colors(&draw_param);
 		break;
@@ -574,6 +590,7 @@ gl_mandelbrot_start(struct mandelbrot_param* parameters)
 	scale_ori.y = draw_param.upper_i - draw_param.lower_i;
 	bounce = 0;
 	print_help = 0;
+	adaptive = 0;
 	bounce = 1;
 
 	ppm = draw_param.picture;
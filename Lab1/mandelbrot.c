@@ -2,12 +2,12 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <malloc.h>
+#include <time.h>
 
 #include "mandelbrot.h"
 #include "ppm.h"
 
 #ifdef MEASURE
-#include <time.h>
 // If we measure, we don't debug as assert() and printf() seriously affect performance
 #undef DEBUG
 #endif
@@ -21,10 +21,24 @@
 #include <pthread.h>
 #endif
 
+#if KERNEL == 1
+#include <stdint.h>
+#endif
+
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
 #define MAX(x, y) (((x) > (y)) ? (x) : (y))
 #define N_ELEMENTS(x) (sizeof(x) / sizeof((x)[0]))
 
+// Size of the low-resolution picture adapt_maxiter() probes
+#define PROBE_WIDTH 64
+#define PROBE_HEIGHT 48
+// Range of iteration budgets adapt_maxiter() may choose from
+#define ADAPT_MIN_MAXITER 32
+#define ADAPT_MAX_MAXITER 65536
+// The iteration budget stops growing when doubling it would let less than
+// this fraction of the probed points escape
+#define ADAPT_ESCAPE_FRACTION 0.002
+
 color_t *color = NULL;
 
 #if NB_THREADS > 0
@@ -54,11 +68,16 @@ struct mandelbrot_timing **timing;
 
 struct mandelbrot_param mandelbrot_param;
 
+// Viewports of the batch being computed, if mandelbrot_batch_size > 0
+struct mandelbrot_param *mandelbrot_batch;
+int mandelbrot_batch_size;
+
 static int num_colors(struct mandelbrot_param* param)
 {
 	return param->maxiter + 1;
 }
 
+#if KERNEL != 1
 /**
  * Calculates if the complex number (Cre, Cim)
  * belongs to the Mandelbrot set
@@ -74,7 +93,7 @@ static int
 is_in_Mandelbrot(float Cre, float Cim, int maxiter)
 {
 	int iter;
-	float x = 0.0, y = 0.0, xto2 = 0.0, yto2 = 0.0, dist2;
+	float x = 0.0, y = 0.0, xto2 = 0.0, yto2 = 0.0, dist2 = 0.0;
 
 	for (iter = 0; dist2 < 4 && iter <= maxiter; iter++)
 	{
@@ -88,13 +107,159 @@ is_in_Mandelbrot(float Cre, float Cim, int maxiter)
 	}
 	return iter;
 }
+#endif
+
+#if KERNEL == 1
+/*
+ * Fixed-point kernel: numbers are 64 bits integers with FIXED_FRAC_BITS
+ * fractional bits. Only integer additions, multiplications and arithmetic
+ * shifts are used, so that the same viewport gives the same picture
+ * whatever the compiler flags or the machine.
+ *
+ * While a point is iterated, |x| and |y| are below 2 and |C| is clamped to
+ * 2, so that every intermediate value stays below 6 and every product below
+ * 36 << (2 * FIXED_FRAC_BITS), which fits in 63 bits.
+ */
+typedef int64_t fixed_t;
+
+#define FIXED_FRAC_BITS 28
+#define FIXED_ONE ((fixed_t) 1 << FIXED_FRAC_BITS)
+#define FIXED_FOUR (4 * FIXED_ONE)
+// Largest viewport coordinate; keeps pixel coordinates computation in 64 bits
+#define FIXED_LIMIT (256 * FIXED_ONE)
+// Number of points iterated together; the lanes loop is written to be
+// vectorized with integer SIMD instructions
+#define FIXED_LANES 8
+
+static fixed_t
+fixed_clamp(fixed_t value, fixed_t limit)
+{
+	return MAX(-limit, MIN(value, limit));
+}
 
+static fixed_t
+fixed_from_float(float value)
+{
+	double scaled;
+
+	// Scaling by a power of two is exact; the conversion truncates
+	scaled = (double) value * FIXED_ONE;
+	scaled = MAX(-(double) FIXED_LIMIT, MIN(scaled, (double) FIXED_LIMIT));
+
+	return (fixed_t) scaled;
+}
+
+/**
+ * Fixed-point version of is_in_Mandelbrot(), iterating FIXED_LANES points
+ * of a line at once.
+ *
+ * @param Cre: Real parts of the points
+ *
+ * @param Cim: Imaginary part common to all points
+ *
+ * @param iter: Receives for each point what is_in_Mandelbrot() would return
+ */
 static void
+is_in_Mandelbrot_fixed(const fixed_t *Cre, fixed_t Cim, int maxiter, int *iter)
+{
+	fixed_t x[FIXED_LANES], y[FIXED_LANES], xto2[FIXED_LANES], yto2[FIXED_LANES];
+	int l, n, running;
+
+	for (l = 0; l < FIXED_LANES; l++)
+	{
+		x[l] = y[l] = xto2[l] = yto2[l] = 0;
+		iter[l] = 0;
+	}
+
+	for (n = 0; n <= maxiter; n++)
+	{
+		running = 0;
+
+		for (l = 0; l < FIXED_LANES; l++)
+		{
+			// All ones while the point did not escape, else zero
+			fixed_t active = -(fixed_t) (xto2[l] + yto2[l] < FIXED_FOUR);
+			// Escaped points do not feed products, which could overflow
+			fixed_t xa = x[l] & active, ya = y[l] & active;
+			fixed_t new_y = ((xa * ya) >> (FIXED_FRAC_BITS - 1)) + Cim;
+			fixed_t new_x = (xto2[l] - yto2[l] + Cre[l]) & active;
+
+			new_y &= active;
+			x[l] = new_x | (x[l] & ~active);
+			y[l] = new_y | (y[l] & ~active);
+			xto2[l] = ((new_x * new_x) >> FIXED_FRAC_BITS) | (xto2[l] & ~active);
+			yto2[l] = ((new_y * new_y) >> FIXED_FRAC_BITS) | (yto2[l] & ~active);
+
+			iter[l] -= active;
+			running |= active;
+		}
+
+		if (!running)
+			break;
+	}
+}
+
+/**
+ * Computes the pixels of the area given in args
+ *
+ * @return : the total number of iterations performed
+ * by is_in_Mandelbrot_fixed() over the area
+ */
+static unsigned long long
+compute_chunk(struct mandelbrot_param *args)
+{
+	int i, j, l, val[FIXED_LANES];
+	fixed_t lower_r, lower_i, span_r, span_i, Cim, Cre[FIXED_LANES];
+	color_t pixel;
+	unsigned long long iterations = 0;
+
+	lower_r = fixed_from_float(args->lower_r);
+	lower_i = fixed_from_float(args->lower_i);
+	span_r = fixed_from_float(args->upper_r) - lower_r;
+	span_i = fixed_from_float(args->upper_i) - lower_i;
+
+	// Iterate through lines
+	for (i = args->begin_h; i < args->end_h; i++)
+	{
+		Cim = fixed_clamp(span_i * i / args->height + lower_i, 2 * FIXED_ONE);
+
+		// Iterate through groups of FIXED_LANES pixels in a line
+		for (j = args->begin_w; j < args->end_w; j += FIXED_LANES)
+		{
+			// Lanes past the end of the area compute the last pixel again
+			for (l = 0; l < FIXED_LANES; l++)
+				Cre[l] = fixed_clamp(span_r * MIN(j + l, args->end_w - 1)
+				    / args->width + lower_r, 2 * FIXED_ONE);
+
+			is_in_Mandelbrot_fixed(Cre, Cim, args->maxiter, val);
+
+			for (l = 0; l < FIXED_LANES && j + l < args->end_w; l++)
+			{
+				iterations += val[l];
+				pixel = val[l] > args->maxiter ? args->mandelbrot_color
+				    : color[val[l] % num_colors(args)];
+
+				ppm_write(args->picture, j + l, i, pixel);
+			}
+		}
+	}
+
+	return iterations;
+}
+#else
+/**
+ * Computes the pixels of the area given in args
+ *
+ * @return : the total number of iterations performed
+ * by is_in_Mandelbrot() over the area
+ */
+static unsigned long long
 compute_chunk(struct mandelbrot_param *args)
 {
 	int i, j, val;
 	float Cim, Cre;
 	color_t pixel;
+	unsigned long long iterations = 0;
 
 	// Iterate hrough lines
 	for (i = args->begin_h; i < args->end_h; i++)
@@ -112,6 +277,7 @@ compute_chunk(struct mandelbrot_param *args)
 			// Gets the value returned by is_in_mandelbrot() and scale it
 			// from 0 to 255, or -1 if (Cre, Cim) is in the mandelbrot set.
 			val = is_in_Mandelbrot(Cre, Cim, args->maxiter);
+			iterations += val;
 
 			// Change a negative value to 0 in val to make mandelbrot
 			// elements to appear black in the final picture.
@@ -121,7 +287,10 @@ compute_chunk(struct mandelbrot_param *args)
 			ppm_write(args->picture, j, i, pixel);
 		}
 	}
+
+	return iterations;
 }
+#endif
 
 /***** You may modify this portion *****/
 #if NB_THREADS > 0
@@ -137,6 +306,10 @@ static volatile int next_chunk;
 #define CHUNK_MASK (LINE_SPLIT - 1)
 #endif
 
+#if LOADBALANCE != 0
+static volatile int next_tile;
+#endif
+
 void
 init_round(struct mandelbrot_thread *args)
 {
@@ -147,14 +320,20 @@ init_round(struct mandelbrot_thread *args)
 #elif LOADBALANCE == 2
   next_chunk = 0;
 #endif
+#if LOADBALANCE != 0
+	next_tile = 0;
+#endif
 }
 
 /*
  * Each thread starts individually this function, where args->id give the thread's id from 0 to NB_THREADS
+ * Returns the number of iterations the thread performed
  */
-void
+unsigned long long
 parallel_mandelbrot(struct mandelbrot_thread *args, struct mandelbrot_param *parameters)
 {
+	unsigned long long iterations = 0;
+
 #if LOADBALANCE == 0
 	// naive *parallel* implementation. Compiled only if LOADBALANCE = 0
 	
@@ -168,7 +347,7 @@ parallel_mandelbrot(struct mandelbrot_thread *args, struct mandelbrot_param *par
 	parameters->end_w = parameters->width;
 
 	// Go
-	compute_chunk(parameters);
+	iterations += compute_chunk(parameters);
 	
 #endif
 #if LOADBALANCE == 1
@@ -197,7 +376,7 @@ parallel_mandelbrot(struct mandelbrot_thread *args, struct mandelbrot_param *par
 	  parameters->end_w = parameters->width;
 	
 	  // Go
-	  compute_chunk(parameters);
+	  iterations += compute_chunk(parameters);
 	}
 #endif
 #if LOADBALANCE == 2
@@ -223,13 +402,72 @@ parallel_mandelbrot(struct mandelbrot_thread *args, struct mandelbrot_param *par
 	  parameters->end_w = MIN(parameters->begin_w + chunk_width, parameters->width);
 	
 	  // Go
-	  compute_chunk(parameters);
+	  iterations += compute_chunk(parameters);
 	}
 #endif
+
+	return iterations;
 }
 /***** end *****/
+
+/*
+ * Batches are split into tiles of one line of one viewport. Consecutive
+ * tiles belong to different viewports, so that small viewports are spread
+ * over all threads.
+ */
+static int
+batch_tiles()
+{
+	int i, height = 0;
+
+	for (i = 0; i < mandelbrot_batch_size; i++)
+		height = MAX(height, mandelbrot_batch[i].height);
+
+	return height * mandelbrot_batch_size;
+}
+
+static unsigned long long
+compute_batch_tile(int tile)
+{
+	struct mandelbrot_param parameters;
+
+	parameters = mandelbrot_batch[tile % mandelbrot_batch_size];
+	parameters.begin_h = tile / mandelbrot_batch_size;
+	parameters.end_h = parameters.begin_h + 1;
+	parameters.begin_w = 0;
+	parameters.end_w = parameters.width;
+
+	// Viewports shorter than the tallest one have no line there
+	if (parameters.begin_h >= parameters.height)
+		return 0;
+
+	return compute_chunk(&parameters);
+}
+
+/*
+ * Each thread computes its share of the tiles of the current batch
+ * Returns the number of iterations the thread performed
+ */
+static unsigned long long
+parallel_mandelbrot_batch(struct mandelbrot_thread *args)
+{
+	unsigned long long iterations = 0;
+	int tile, tiles = batch_tiles();
+
+#if LOADBALANCE == 0
+	// Tiles are dealt round-robin to threads
+	for (tile = args->id; tile < tiles; tile += NB_THREADS)
+		iterations += compute_batch_tile(tile);
 #else
-void
+	// Threads take the next tile until there is none left
+	while ((tile = __sync_fetch_and_add(&next_tile, 1)) < tiles)
+		iterations += compute_batch_tile(tile);
+#endif
+
+	return iterations;
+}
+#else
+unsigned long long
 sequential_mandelbrot(struct mandelbrot_param *parameters)
 {
 	// Define the region compute_chunk() has to compute
@@ -241,7 +479,19 @@ sequential_mandelbrot(struct mandelbrot_param *parameters)
 	parameters->end_w = parameters->width;
 
 	// Go
-	compute_chunk(parameters);
+	return compute_chunk(parameters);
+}
+
+static unsigned long long
+sequential_mandelbrot_batch()
+{
+	unsigned long long iterations = 0;
+	int i;
+
+	for (i = 0; i < mandelbrot_batch_size; i++)
+		iterations += sequential_mandelbrot(&mandelbrot_batch[i]);
+
+	return iterations;
 }
 #endif
 
@@ -272,7 +522,15 @@ run_thread(void * buffer)
 		clock_gettime(CLOCK_MONOTONIC, &args->timing.start);
 #endif
 
-		parallel_mandelbrot(args, &param);
+#ifdef MEASURE
+		args->timing.iterations = mandelbrot_batch_size > 0
+		    ? parallel_mandelbrot_batch(args) : parallel_mandelbrot(args, &param);
+#else
+		if (mandelbrot_batch_size > 0)
+			parallel_mandelbrot_batch(args);
+		else
+			parallel_mandelbrot(args, &param);
+#endif
 
 #ifdef MEASURE
 		clock_gettime(CLOCK_MONOTONIC, &args->timing.stop);
@@ -341,6 +599,184 @@ update_colors(struct mandelbrot_param* param)
 	}
 }
 
+#if KERNEL == 1
+struct probe_point
+{
+	fixed_t x, y, xto2, yto2;
+	fixed_t Cre, Cim;
+	int iter;
+};
+
+/**
+ * Places a probed point at column j and line i of the probe, with the
+ * coordinates compute_chunk() would give it
+ */
+static void
+probe_init(struct probe_point *point, struct mandelbrot_param *param, int i,
+    int j)
+{
+	fixed_t lower_r, lower_i;
+
+	lower_r = fixed_from_float(param->lower_r);
+	lower_i = fixed_from_float(param->lower_i);
+
+	point->x = point->y = point->xto2 = point->yto2 = 0;
+	point->Cim = fixed_clamp((fixed_from_float(param->upper_i) - lower_i)
+	    * i / PROBE_HEIGHT + lower_i, 2 * FIXED_ONE);
+	point->Cre = fixed_clamp((fixed_from_float(param->upper_r) - lower_r)
+	    * j / PROBE_WIDTH + lower_r, 2 * FIXED_ONE);
+	point->iter = 0;
+}
+
+/**
+ * Resumes the computation of is_in_Mandelbrot_fixed() for a probed point,
+ * one lane at a time, up to the iteration budget maxiter
+ */
+static void
+probe_iterate(struct probe_point *point, int maxiter)
+{
+	while (point->xto2 + point->yto2 < FIXED_FOUR && point->iter <= maxiter)
+	{
+		point->y = ((point->x * point->y) >> (FIXED_FRAC_BITS - 1)) + point->Cim;
+		point->x = point->xto2 - point->yto2 + point->Cre;
+		point->xto2 = (point->x * point->x) >> FIXED_FRAC_BITS;
+		point->yto2 = (point->y * point->y) >> FIXED_FRAC_BITS;
+		point->iter++;
+	}
+}
+#else
+struct probe_point
+{
+	float x, y, xto2, yto2;
+	float Cre, Cim;
+	int iter;
+};
+
+/**
+ * Places a probed point at column j and line i of the probe
+ */
+static void
+probe_init(struct probe_point *point, struct mandelbrot_param *param, int i,
+    int j)
+{
+	point->x = point->y = point->xto2 = point->yto2 = 0;
+	point->Cim = (float) i / PROBE_HEIGHT * (param->upper_i - param->lower_i)
+	    + param->lower_i;
+	point->Cre = (float) j / PROBE_WIDTH * (param->upper_r - param->lower_r)
+	    + param->lower_r;
+	point->iter = 0;
+}
+
+/**
+ * Resumes the computation of is_in_Mandelbrot() for a probed point, up to
+ * the iteration budget maxiter
+ */
+static void
+probe_iterate(struct probe_point *point, int maxiter)
+{
+	while (point->xto2 + point->yto2 < 4 && point->iter <= maxiter)
+	{
+		point->y = point->x * point->y;
+		point->y = point->y + point->y + point->Cim;
+		point->x = point->xto2 - point->yto2 + point->Cre;
+		point->xto2 = point->x * point->x;
+		point->yto2 = point->y * point->y;
+		point->iter++;
+	}
+}
+#endif
+
+static double
+elapsed_seconds(struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec)
+	    / 1000000000.0;
+}
+
+/**
+ * Chooses the iteration budget of the frame described by param from a low
+ * resolution probe of its viewport, and stores it in param->maxiter.
+ *
+ * The budget doubles as long as doing so lets a noticeable fraction of the
+ * probed points escape, and the frame, whose cost is extrapolated from the
+ * probe, would still be computed within frame_time seconds.
+ *
+ * The color vector must be updated if the budget changes.
+ *
+ * @return : the chosen iteration budget
+ */
+int
+adapt_maxiter(struct mandelbrot_param *param, double frame_time)
+{
+	struct probe_point *points;
+	struct timespec start;
+	int i, j, n, bounded, escaped, budget, chosen;
+	double scale;
+
+	// Keep the current budget if there is no memory to probe
+	points = malloc(sizeof(struct probe_point) * PROBE_WIDTH * PROBE_HEIGHT);
+	if (points == NULL)
+		return param->maxiter;
+
+	for (i = 0; i < PROBE_HEIGHT; i++)
+		for (j = 0; j < PROBE_WIDTH; j++)
+			probe_init(&points[i * PROBE_WIDTH + j], param, i, j);
+
+	// Full frame pixels per probed point, and per thread
+	scale = (double) param->width * param->height / (PROBE_WIDTH * PROBE_HEIGHT);
+#if NB_THREADS > 0
+	scale /= NB_THREADS;
+#endif
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	chosen = budget = ADAPT_MIN_MAXITER;
+	bounded = 0;
+	for (n = 0; n < PROBE_WIDTH * PROBE_HEIGHT; n++)
+	{
+		probe_iterate(&points[n], budget);
+		bounded += points[n].iter > budget;
+	}
+
+	while (bounded > 0 && budget * 2 <= ADAPT_MAX_MAXITER)
+	{
+		// Try twice as many iterations on the points still bounded
+		escaped = 0;
+		for (n = 0; n < PROBE_WIDTH * PROBE_HEIGHT; n++)
+		{
+			if (points[n].iter > budget)
+			{
+				probe_iterate(&points[n], budget * 2);
+				escaped += points[n].iter <= budget * 2;
+			}
+		}
+		bounded -= escaped;
+		budget *= 2;
+
+		// Stop if the frame would take too long with the new budget. Points
+		// resume where the smaller budgets left them, so the probe has run
+		// exactly the iterations of one pass at this budget, and the time
+		// it took so far, scaled to the frame, is the frame's cost.
+		if (elapsed_seconds(&start) * scale > frame_time)
+			break;
+
+		chosen = budget;
+
+		// Stop if more iterations hardly make any difference
+		if (escaped < ADAPT_ESCAPE_FRACTION * PROBE_WIDTH * PROBE_HEIGHT)
+			break;
+	}
+
+	free(points);
+	param->maxiter = chosen;
+
+	return chosen;
+}
+
 void
 init_mandelbrot(struct mandelbrot_param *param)
 {
@@ -425,13 +861,56 @@ compute_mandelbrot(struct mandelbrot_param param)
 	clock_gettime(CLOCK_MONOTONIC, &sequential.start);
 #endif
 
+#ifdef MEASURE
+	sequential.iterations = sequential_mandelbrot(&param);
+#else
 	sequential_mandelbrot(&param);
+#endif
+
+#ifdef MEASURE
+	clock_gettime(CLOCK_MONOTONIC, &sequential.stop);
+#endif
+#endif
 
 #ifdef MEASURE
+	return timing;
+#endif
+}
+
+/**
+ * Computes several viewports, each in the picture of its parameters, with
+ * a single dispatch to the thread pool. All viewports must use the maxiter
+ * the colors were last updated for.
+ */
+#ifdef MEASURE
+struct mandelbrot_timing**
+#else
+void
+#endif
+compute_mandelbrot_batch(struct mandelbrot_param *params, int count)
+{
+	mandelbrot_batch = params;
+	mandelbrot_batch_size = count;
+
+#if NB_THREADS > 0
+	// Trigger threads' resume
+	pthread_barrier_wait(&thread_pool_barrier);
+
+	// Wait for the threads to be done
+	pthread_barrier_wait(&thread_pool_barrier);
+#else
+#ifdef MEASURE
+	clock_gettime(CLOCK_MONOTONIC, &sequential.start);
+	sequential.iterations = sequential_mandelbrot_batch();
 	clock_gettime(CLOCK_MONOTONIC, &sequential.stop);
+#else
+	sequential_mandelbrot_batch();
 #endif
 #endif
 
+	// Back to single viewports
+	mandelbrot_batch_size = 0;
+
 #ifdef MEASURE
 	return timing;
 #endif
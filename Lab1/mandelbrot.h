@@ -40,12 +40,17 @@ struct mandelbrot_timing
 {
   // Monitors general algorithm start and stop time
   struct timespec start, stop;
+  // Number of iterations of the Mandelbrot loop run between start and stop
+  unsigned long long iterations;
 };
 
 struct mandelbrot_timing**
 compute_mandelbrot(struct mandelbrot_param);
+struct mandelbrot_timing**
+compute_mandelbrot_batch(struct mandelbrot_param*, int count);
 #else
 void compute_mandelbrot(struct mandelbrot_param);
+void compute_mandelbrot_batch(struct mandelbrot_param*, int count);
 #endif
 
 void init_mandelbrot(struct mandelbrot_param*);
@@ -53,5 +58,6 @@ void destroy_mandelbrot();
 
 void init_ppm(struct mandelbrot_param*);
 void update_colors(struct mandelbrot_param*);
+int adapt_maxiter(struct mandelbrot_param*, double frame_time);
 
 #endif /* MANDELBROT_H_ */
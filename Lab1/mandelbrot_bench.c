@@ -0,0 +1,388 @@
+/*
+ * mandelbrot_bench.c
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ *
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Renders a fixed catalogue of scenes several times with the KERNEL,
+ * LOADBALANCE and NB_THREADS settings this binary was compiled with, and
+ * reports per scene:
+ *
+ * scene kernel nb_threads loadbalance width height maxiter frames median_ms p95_ms mpixel_s giter_s hash
+ *
+ * where hash identifies the content of the rendered picture; with the
+ * fixed-point kernel it is the same on every machine.
+ *
+ * With -a, the iteration budget of each scene is instead chosen by
+ * adapt_maxiter() to hold the given frame time.
+ *
+ * The gallery scenes render 64 thumbnails one after the other ("gallery")
+ * or as a single batch ("gallery-batch"); their frame time covers all
+ * thumbnails.
+ *
+ * When given a baseline file (a previous output of this program), the run
+ * fails if the median frame time of any scene grew by more than the
+ * regression threshold.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "mandelbrot.h"
+
+#ifndef MEASURE
+#error The benchmark needs the timing records compiled with MEASURE
+#endif
+
+#define BENCH_WIDTH 500
+#define BENCH_HEIGHT 375
+
+#define DEFAULT_FRAMES 10
+#define DEFAULT_WARMUP 1
+#define DEFAULT_THRESHOLD 10.0
+
+#define MAX_LINE_LENGTH 256
+
+#if NB_THREADS > 0
+#define NB_TIMINGS NB_THREADS
+#else
+#define NB_TIMINGS 1
+#endif
+
+struct scene
+{
+	const char *name;
+	float lower_r, upper_r, lower_i, upper_i;
+	int maxiter;
+};
+
+// All scenes keep the 4:3 ratio of the benchmark picture
+static const struct scene scenes[] =
+	{
+		{ "full", -2, 0.6, -1, 1, 256 }, // Default viewport
+		{ "seahorse", -0.7530, -0.7390, 0.0900, 0.1005, 1024 }, // Seahorse valley
+		{ "interior", -0.3, -0.1, -0.075, 0.075, 512 }, // Inside the main cardioid, every pixel runs maxiter
+		{ "maxiter", -2, 0.6, -1, 1, 4096 }, // Default viewport with a high iteration budget
+	};
+
+#define NB_SCENES (sizeof(scenes) / sizeof(struct scene))
+
+// Thumbnails gallery, each thumbnail zooming further than the previous one
+#define GALLERY_SIZE 64
+#define GALLERY_WIDTH 128
+#define GALLERY_HEIGHT 96
+#define GALLERY_MAXITER 256
+#define GALLERY_ZOOM 0.9
+
+static double
+timespec_diff_ms(struct timespec start, struct timespec stop)
+{
+	return (stop.tv_sec - start.tv_sec) * 1000.0 + (stop.tv_nsec - start.tv_nsec)
+	    / 1000000.0;
+}
+
+static int
+compare_double(const void *a, const void *b)
+{
+	double aa = *(const double*) a;
+	double bb = *(const double*) b;
+
+	return (aa > bb) - (aa < bb);
+}
+
+/**
+ * Returns the value below which lie percent % of the sorted samples
+ */
+static double
+percentile(double *sorted, int count, int percent)
+{
+	int index;
+
+	index = (count * percent + 99) / 100 - 1;
+	if (index < 0)
+		index = 0;
+
+	return sorted[index];
+}
+
+/**
+ * Looks up the median frame time recorded for the same scene and settings
+ * in a baseline file, rendered at the size and iteration budget of
+ * viewport. Returns a negative value if there is none.
+ */
+static double
+baseline_median(const char *filename, const char *scene,
+    const struct mandelbrot_param *viewport)
+{
+	FILE *file;
+	char line[MAX_LINE_LENGTH], name[MAX_LINE_LENGTH];
+	int kernel, nb_threads, loadbalance, width, height, maxiter;
+	double median, result = -1;
+
+	file = fopen(filename, "r");
+	if (file == NULL)
+		return -1;
+
+	while (fgets(line, MAX_LINE_LENGTH, file) != NULL)
+	{
+		if (sscanf(line, "%255s %i %i %i %i %i %i %*i %lf", name, &kernel,
+		    &nb_threads, &loadbalance, &width, &height, &maxiter, &median) != 8)
+			continue;
+
+		if (strcmp(name, scene) == 0 && kernel == KERNEL && nb_threads == NB_THREADS
+		    && loadbalance == LOADBALANCE && width == viewport->width
+		    && height == viewport->height && maxiter == viewport->maxiter)
+			result = median;
+	}
+	fclose(file);
+
+	return result;
+}
+
+/**
+ * Renders frames times, after warmup untimed frames, count viewports
+ * either in a single batch or one after the other. Stores the time of each
+ * frame in frame_ms, sorted, and returns the iterations of all frames.
+ */
+static unsigned long long
+render(struct mandelbrot_param *viewports, int count, int batch, int frames,
+    int warmup, double *frame_ms)
+{
+	struct mandelbrot_timing **timing;
+	struct timespec start, stop;
+	unsigned long long iterations = 0;
+	int i, j, k;
+
+	for (i = -warmup; i < frames; i++)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		if (batch)
+		{
+			timing = compute_mandelbrot_batch(viewports, count);
+			for (k = 0; k < NB_TIMINGS; k++)
+				iterations += i >= 0 ? timing[k]->iterations : 0;
+		}
+		else
+		{
+			for (j = 0; j < count; j++)
+			{
+				timing = compute_mandelbrot(viewports[j]);
+				for (k = 0; k < NB_TIMINGS; k++)
+					iterations += i >= 0 ? timing[k]->iterations : 0;
+			}
+		}
+		clock_gettime(CLOCK_MONOTONIC, &stop);
+
+		if (i >= 0)
+			frame_ms[i] = timespec_diff_ms(start, stop);
+	}
+
+	qsort(frame_ms, frames, sizeof(double), compare_double);
+
+	return iterations;
+}
+
+/**
+ * Prints the performance of a scene of count viewports, and returns 1 if it
+ * regressed compared to the baseline, if any, else 0.
+ */
+static int
+report(const char *name, struct mandelbrot_param *viewports, int count,
+    int frames, double *frame_ms, unsigned long long iterations,
+    const char *baseline, double threshold)
+{
+	double total_ms = 0, reference;
+	unsigned long long hash = 0;
+	int j;
+
+	for (j = 0; j < frames; j++)
+		total_ms += frame_ms[j];
+
+	for (j = 0; j < count; j++)
+		hash = hash * 31 + ppm_hash(viewports[j].picture);
+
+	printf("%s %i %i %i %i %i %i %i %.3f %.3f %.2f %.3f %016llx\n", name,
+	    KERNEL, NB_THREADS, LOADBALANCE, viewports[0].width,
+	    viewports[0].height, viewports[0].maxiter, frames, percentile(frame_ms,
+	        frames, 50), percentile(frame_ms, frames, 95), (double) count
+	        * viewports[0].width * viewports[0].height * frames / total_ms
+	        / 1000.0, iterations / total_ms / 1000000.0, hash);
+
+	if (baseline == NULL)
+		return 0;
+
+	reference = baseline_median(baseline, name, &viewports[0]);
+	if (reference > 0 && percentile(frame_ms, frames, 50) > reference * (1
+	    + threshold / 100))
+	{
+		fprintf(stderr, "[REGRESSION] Scene %s: median frame time %.3f ms "
+			"is more than %.1f%% above baseline %.3f ms\n", name, percentile(
+		    frame_ms, frames, 50), threshold, reference);
+		return 1;
+	}
+
+	return 0;
+}
+
+static void
+usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [-n frames] [-w warmup frames] [-s scene] "
+		"[-b baseline file] [-t regression threshold in %%] "
+		"[-a target frame time in ms]\n", name);
+}
+
+int
+main(int argc, char ** argv)
+{
+	struct mandelbrot_param param, thumbnails[GALLERY_SIZE];
+	double *frame_ms, threshold, target_ms, center_r, center_i, half_r;
+	unsigned long long iterations;
+	const char *only, *baseline;
+	int frames, warmup, opt, regressed;
+	unsigned int i;
+
+	frames = DEFAULT_FRAMES;
+	warmup = DEFAULT_WARMUP;
+	threshold = DEFAULT_THRESHOLD;
+	target_ms = 0;
+	only = NULL;
+	baseline = NULL;
+
+	while ((opt = getopt(argc, argv, "n:w:s:b:t:a:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'n':
+			frames = atoi(optarg);
+			break;
+		case 'w':
+			warmup = atoi(optarg);
+			break;
+		case 's':
+			only = optarg;
+			break;
+		case 'b':
+			baseline = optarg;
+			break;
+		case 't':
+			threshold = atof(optarg);
+			break;
+		case 'a':
+			target_ms = atof(optarg);
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (frames < 1)
+	{
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	frame_ms = malloc(sizeof(double) * frames);
+
+	param.height = BENCH_HEIGHT;
+	param.width = BENCH_WIDTH;
+	param.lower_r = scenes[0].lower_r;
+	param.upper_r = scenes[0].upper_r;
+	param.lower_i = scenes[0].lower_i;
+	param.upper_i = scenes[0].upper_i;
+	param.maxiter = scenes[0].maxiter;
+	param.mandelbrot_color.red = 0;
+	param.mandelbrot_color.green = 0;
+	param.mandelbrot_color.blue = 0;
+
+	init_mandelbrot(&param);
+
+	regressed = 0;
+	for (i = 0; i < NB_SCENES; i++)
+	{
+		if (only != NULL && strcmp(only, scenes[i].name) != 0)
+			continue;
+
+		param.lower_r = scenes[i].lower_r;
+		param.upper_r = scenes[i].upper_r;
+		param.lower_i = scenes[i].lower_i;
+		param.upper_i = scenes[i].upper_i;
+		param.maxiter = scenes[i].maxiter;
+		if (target_ms > 0)
+			adapt_maxiter(&param, target_ms / 1000.0);
+		update_colors(&param);
+
+		iterations = render(&param, 1, 0, frames, warmup, frame_ms);
+		regressed |= report(scenes[i].name, &param, 1, frames, frame_ms,
+		    iterations, baseline, threshold);
+	}
+
+	// Thumbnails zooming into the seahorse valley, rendered one by one and
+	// then as a single batch
+	if (only == NULL || strncmp(only, "gallery", strlen("gallery")) == 0)
+	{
+		param.maxiter = GALLERY_MAXITER;
+		update_colors(&param);
+
+		center_r = (scenes[1].lower_r + scenes[1].upper_r) / 2;
+		center_i = (scenes[1].lower_i + scenes[1].upper_i) / 2;
+		half_r = (scenes[0].upper_r - scenes[0].lower_r) / 2;
+		for (i = 0; i < GALLERY_SIZE; i++)
+		{
+			thumbnails[i] = param;
+			thumbnails[i].width = GALLERY_WIDTH;
+			thumbnails[i].height = GALLERY_HEIGHT;
+			thumbnails[i].lower_r = center_r - half_r;
+			thumbnails[i].upper_r = center_r + half_r;
+			thumbnails[i].lower_i = center_i - half_r * 3 / 4;
+			thumbnails[i].upper_i = center_i + half_r * 3 / 4;
+			thumbnails[i].picture = ppm_alloc(GALLERY_WIDTH, GALLERY_HEIGHT);
+			half_r *= GALLERY_ZOOM;
+		}
+
+		if (only == NULL || strcmp(only, "gallery") == 0)
+		{
+			iterations = render(thumbnails, GALLERY_SIZE, 0, frames, warmup,
+			    frame_ms);
+			regressed |= report("gallery", thumbnails, GALLERY_SIZE, frames,
+			    frame_ms, iterations, baseline, threshold);
+		}
+
+		if (only == NULL || strcmp(only, "gallery-batch") == 0)
+		{
+			iterations = render(thumbnails, GALLERY_SIZE, 1, frames, warmup,
+			    frame_ms);
+			regressed |= report("gallery-batch", thumbnails, GALLERY_SIZE,
+			    frames, frame_ms, iterations, baseline, threshold);
+		}
+
+		for (i = 0; i < GALLERY_SIZE; i++)
+			ppm_free(thumbnails[i].picture);
+	}
+
+	destroy_mandelbrot(param);
+	free(frame_ms);
+
+	return regressed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -113,6 +113,32 @@ ppm_read(struct ppm * picture, int x, int y)
 	return color;
 }
 
+/**
+ * Returns the 64 bits FNV-1a hash of the pixels of a picture, ignoring the
+ * padding at the end of rows, so that pictures can be compared by content
+ */
+unsigned long long
+ppm_hash(struct ppm * picture)
+{
+	unsigned long long hash = 14695981039346656037ULL;
+	int i, j;
+	color_t color;
+
+	for (i = 0; i < picture->height; i++)
+	{
+		for (j = 0; j < picture->width; j++)
+		{
+			color = *coord_to_ptr(picture, j, i);
+
+			hash = (hash ^ color.red) * 1099511628211ULL;
+			hash = (hash ^ color.green) * 1099511628211ULL;
+			hash = (hash ^ color.blue) * 1099511628211ULL;
+		}
+	}
+
+	return hash;
+}
+
 void
 ppm_printf(struct ppm * ppm)
 {
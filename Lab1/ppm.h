@@ -27,5 +27,6 @@ void ppm_write(struct ppm *, int x, int y, color_t);
 color_t ppm_read(struct ppm *, int x, int y);
 void ppm_printf(struct ppm *);
 int ppm_align(int, int);
+unsigned long long ppm_hash(struct ppm *);
 
 #endif
@@ -0,0 +1,244 @@
+/*
+ * deque.c
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ * 
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ * 
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ * 
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "deque.h"
+#include "non_blocking.h"
+
+#define CACHE_LINE_SIZE 64
+
+// Circular array of elements. Arrays replaced when growing may still be
+// read by thieves, so they stay chained to the new one until deque_free();
+// together they take less than twice the size of the largest.
+struct deque_array
+{
+  size_t mask;
+  struct deque_array *prev;
+  void *slots[];
+};
+
+// Elements are in [top, bottom). Both indices only grow, except that the
+// owner moves bottom back and forth when popping; they are compared
+// through their signed difference.
+struct deque
+{
+  size_t top __attribute__((aligned(CACHE_LINE_SIZE)));
+  size_t bottom __attribute__((aligned(CACHE_LINE_SIZE)));
+  struct deque_array *array;
+};
+
+static struct deque_array *
+deque_array_alloc(size_t size)
+{
+  struct deque_array *array;
+
+  if (posix_memalign((void**)&array, CACHE_LINE_SIZE,
+      sizeof(struct deque_array) + size * sizeof(void*)) != 0)
+    return NULL;
+
+  array->mask = size - 1;
+  array->prev = NULL;
+
+  return array;
+}
+
+static void*
+deque_array_get(struct deque_array *array, size_t i)
+{
+  return __atomic_load_n(&array->slots[i & array->mask], __ATOMIC_RELAXED);
+}
+
+static void
+deque_array_put(struct deque_array *array, size_t i, void *data)
+{
+  __atomic_store_n(&array->slots[i & array->mask], data, __ATOMIC_RELAXED);
+}
+
+deque_t *
+deque_alloc(size_t capacity)
+{
+  deque_t *deque;
+  size_t size;
+
+  for (size = 1; size < capacity; size *= 2)
+    ;
+
+  if (posix_memalign((void**)&deque, CACHE_LINE_SIZE, sizeof(struct deque)) != 0)
+    return NULL;
+
+  deque->array = deque_array_alloc(size);
+  if (deque->array == NULL)
+  {
+    free(deque);
+    return NULL;
+  }
+  deque->top = 0;
+  deque->bottom = 0;
+
+  return deque;
+}
+
+int
+deque_free(deque_t *deque)
+{
+  struct deque_array *array, *prev;
+
+  assert(deque != NULL);
+
+  for (array = deque->array; array != NULL; array = prev)
+  {
+    prev = array->prev;
+    free(array);
+  }
+  free(deque);
+
+  return 0;
+}
+
+// Copy the elements to an array twice as large. Only the owner writes
+// slots, so thieves may keep reading the old array meanwhile.
+static struct deque_array *
+deque_grow(deque_t *deque, struct deque_array *array, size_t top, size_t bottom)
+{
+  struct deque_array *grown = deque_array_alloc(2 * (array->mask + 1));
+  size_t i;
+
+  if (grown == NULL)
+    return NULL;
+
+  for (i = top; i != bottom; i++)
+    deque_array_put(grown, i, deque_array_get(array, i));
+  grown->prev = array;
+
+  __atomic_store_n(&deque->array, grown, __ATOMIC_RELEASE);
+
+  return grown;
+}
+
+int
+deque_push(deque_t *deque, void *data)
+{
+  size_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED);
+  size_t top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+  struct deque_array *array = __atomic_load_n(&deque->array, __ATOMIC_RELAXED);
+
+  if (bottom - top > array->mask)
+  {
+    array = deque_grow(deque, array, top, bottom);
+    if (array == NULL)
+      return -1;
+  }
+
+  deque_array_put(array, bottom, data);
+  // Thieves that see the new bottom see the element too
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+
+  return 0;
+}
+
+int
+deque_pop(deque_t *deque, void **data)
+{
+  size_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) - 1;
+  struct deque_array *array = __atomic_load_n(&deque->array, __ATOMIC_RELAXED);
+  size_t top;
+  void *element;
+
+  // Reserve the last element before looking at top, so that a thief and
+  // the owner cannot both miss each other
+  __atomic_store_n(&deque->bottom, bottom, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  top = __atomic_load_n(&deque->top, __ATOMIC_RELAXED);
+
+  if ((intptr_t)(bottom - top) < 0)
+  {
+    // Empty
+    __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+    return -1;
+  }
+
+  element = deque_array_get(array, bottom);
+  if (bottom == top)
+  {
+    // Last element: thieves may want it too, so race for it on top
+    int won;
+
+    perturb();
+    won = __atomic_compare_exchange_n(&deque->top, &top, top + 1, 0,
+        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+    __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+    if (!won)
+      return -1;
+  }
+
+  if (data != NULL)
+    *data = element;
+
+  return 0;
+}
+
+int
+deque_steal(deque_t *deque, void **data)
+{
+  size_t top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+  size_t bottom;
+  struct deque_array *array;
+  void *element;
+
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  bottom = __atomic_load_n(&deque->bottom, __ATOMIC_ACQUIRE);
+
+  if ((intptr_t)(bottom - top) <= 0)
+    return -1;
+
+  // Read the element before claiming it, as the owner may overwrite its
+  // slot right after top moved
+  array = __atomic_load_n(&deque->array, __ATOMIC_ACQUIRE);
+  element = deque_array_get(array, top);
+  perturb();
+  if (!__atomic_compare_exchange_n(&deque->top, &top, top + 1, 0,
+      __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+    return DEQUE_ABORT;
+
+  if (data != NULL)
+    *data = element;
+
+  return 0;
+}
+
+size_t
+deque_size(deque_t *deque)
+{
+  size_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED);
+  size_t top = __atomic_load_n(&deque->top, __ATOMIC_RELAXED);
+
+  return (intptr_t)(bottom - top) > 0 ? bottom - top : 0;
+}
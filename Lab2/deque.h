@@ -0,0 +1,56 @@
+/*
+ * deque.h
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ * 
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ * 
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ * 
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+
+#include <stddef.h>
+
+#ifndef DEQUE_H_
+#define DEQUE_H_
+
+// Work-stealing deque (D. Chase and Y. Lev, 2005, with the memory orders
+// of N. M. Lê et al., 2013). A single owner thread pushes and pops at the
+// bottom without any atomic read-modify-write except when taking the last
+// element; any other thread may steal from the top with a CAS. The
+// circular array grows when full.
+
+typedef struct deque deque_t;
+
+// The capacity is rounded up to a power of two
+deque_t * deque_alloc(size_t capacity);
+int       deque_free(deque_t *deque);
+
+// Owner only. Push returns -1 if the array could not grow.
+int       deque_push(deque_t *deque, void *data);
+// Owner only. Returns -1 if the deque is empty.
+int       deque_pop(deque_t *deque, void **data);
+
+// Returned by deque_steal() when another thread took the element first
+#define DEQUE_ABORT -2
+
+// Any thread. Returns -1 if the deque is empty and DEQUE_ABORT if the
+// steal lost a race, after which the thief may retry or try another deque.
+int       deque_steal(deque_t *deque, void **data);
+
+// Number of elements, only exact while no other thread uses the deque
+size_t    deque_size(deque_t *deque);
+
+#endif /* DEQUE_H_ */
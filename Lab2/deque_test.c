@@ -0,0 +1,427 @@
+/*
+ * deque_test.c
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ * 
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ * 
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ * 
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include <sched.h>
+
+#include "deque.h"
+
+#define test_run(test)\
+  printf("[%s:%s:%i] Running test '%s'... ", __FILE__, __FUNCTION__, __LINE__, #test);\
+  test_setup();\
+  if(test())\
+  {\
+    printf("passed\n");\
+  }\
+  else\
+  {\
+    printf("failed\n");\
+  }\
+  test_teardown();
+
+// Elements carry the producer and a sequence number, so that consumers can
+// check the order
+#define ELEMENT(thread, seq) ((void*)(((size_t)(thread) << 32) | ((size_t)(seq) + 1)))
+#define ELEMENT_THREAD(element) ((size_t)(element) >> 32)
+#define ELEMENT_SEQ(element) (((size_t)(element) & 0xffffffff) - 1)
+
+// Capacity of the deques in tests, small so that they have to grow
+#define DEQUE_CAPACITY 16
+
+static deque_t *deque;
+
+void
+test_init()
+{
+  // Initialize your test batch
+}
+
+void
+test_setup()
+{
+  // Allocate and initialize your test deque before each test
+  deque = deque_alloc(DEQUE_CAPACITY);
+}
+
+void
+test_teardown()
+{
+  deque_free(deque);
+}
+
+void
+test_finalize()
+{
+  // Destroy properly your test batch
+}
+
+struct thread_test_args
+{
+  int id;
+  size_t count;
+};
+typedef struct thread_test_args thread_test_args_t;
+
+static int
+run_test_function(void* (*func)(void* arg), thread_test_args_t *args)
+{
+  pthread_attr_t attr;
+  pthread_t thread[NB_THREADS];
+
+  int i;
+  int result = 0;
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      args[i].id = i;
+      args[i].count = 0;
+      pthread_create(&thread[i], &attr, func, &args[i]);
+    }
+
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      void *ret;
+      pthread_join(thread[i], &ret);
+      if (ret != 0)
+        result = -1;
+    }
+
+  return result;
+}
+
+int
+test_lifo()
+{
+  void *element;
+  int i;
+
+  // The owner takes back its last element first
+  for (i = 0; i < DEQUE_CAPACITY; i++)
+    deque_push(deque, ELEMENT(0, i));
+
+  for (i = DEQUE_CAPACITY - 1; i >= 0; i--)
+    if (deque_pop(deque, &element) != 0 || element != ELEMENT(0, i))
+      return 0;
+
+  return deque_pop(deque, &element) == -1 && deque_size(deque) == 0;
+}
+
+int
+test_steal_fifo()
+{
+  void *element;
+  int i;
+
+  // Thieves take the oldest element, here from the owner thread itself
+  for (i = 0; i < DEQUE_CAPACITY; i++)
+    deque_push(deque, ELEMENT(0, i));
+
+  for (i = 0; i < DEQUE_CAPACITY / 2; i++)
+    if (deque_steal(deque, &element) != 0 || element != ELEMENT(0, i))
+      return 0;
+  for (i = DEQUE_CAPACITY - 1; i >= DEQUE_CAPACITY / 2; i--)
+    if (deque_pop(deque, &element) != 0 || element != ELEMENT(0, i))
+      return 0;
+
+  return deque_steal(deque, &element) == -1;
+}
+
+int
+test_grow()
+{
+  void *element;
+  int i;
+
+  // Steal some elements first so that the copied range wraps around the
+  // end of the array
+  for (i = 0; i < DEQUE_CAPACITY; i++)
+    deque_push(deque, ELEMENT(0, i));
+  for (i = 0; i < DEQUE_CAPACITY / 2; i++)
+    deque_steal(deque, NULL);
+
+  for (i = DEQUE_CAPACITY; i < MAX_PUSH_POP; i++)
+    if (deque_push(deque, ELEMENT(0, i)) != 0)
+      return 0;
+  if (deque_size(deque) != MAX_PUSH_POP - DEQUE_CAPACITY / 2)
+    return 0;
+
+  for (i = MAX_PUSH_POP - 1; i >= DEQUE_CAPACITY / 2; i--)
+    if (deque_pop(deque, &element) != 0 || element != ELEMENT(0, i))
+      return 0;
+
+  return deque_pop(deque, &element) == -1;
+}
+
+static int seen[MAX_PUSH_POP * NB_THREADS];
+static volatile size_t taken;
+
+static int
+take(void *element)
+{
+  if (ELEMENT_THREAD(element) != 0 || ELEMENT_SEQ(element) >= MAX_PUSH_POP * NB_THREADS)
+    return -1;
+
+  __sync_fetch_and_add(&seen[ELEMENT_SEQ(element)], 1);
+  __sync_fetch_and_add(&taken, 1);
+
+  return 0;
+}
+
+static void*
+thread_test_steal(void* arg)
+{
+  thread_test_args_t *args = arg;
+  void *element;
+  int i;
+
+  if (args->id == 0)
+    {
+      // The owner pushes everything, growing the deque, and pops back one
+      // element out of three, so that it races with thieves on the last
+      // elements
+      for (i = 0; i < MAX_PUSH_POP * NB_THREADS; i++)
+        {
+          if (deque_push(deque, ELEMENT(0, i)) != 0)
+            return (void*)-1;
+          if (i % 3 == 2 && deque_pop(deque, &element) == 0 && take(element) != 0)
+            return (void*)-1;
+        }
+      while (deque_pop(deque, &element) == 0)
+        if (take(element) != 0)
+          return (void*)-1;
+    }
+  else
+    {
+      while (taken < MAX_PUSH_POP * NB_THREADS)
+        {
+          int ret = deque_steal(deque, &element);
+
+          if (ret == 0)
+            {
+              if (take(element) != 0)
+                return (void*)-1;
+              args->count++;
+            }
+          else if (ret == -1)
+            sched_yield();
+        }
+    }
+
+  return (void*)0;
+}
+
+int
+test_steal_safe()
+{
+  thread_test_args_t args[NB_THREADS];
+  int i;
+
+  memset(seen, 0, sizeof(seen));
+  taken = 0;
+
+  if (run_test_function(&thread_test_steal, args) != 0)
+    return 0;
+
+  // Every element was taken exactly once, by the owner or a thief
+  for (i = 0; i < MAX_PUSH_POP * NB_THREADS; i++)
+    if (seen[i] != 1)
+      return 0;
+
+  return deque_steal(deque, NULL) == -1 && deque_pop(deque, NULL) == -1;
+}
+
+static void*
+thread_test_steal_empty(void* arg)
+{
+  thread_test_args_t *args = arg;
+  void *element;
+  int i;
+
+  // The owner keeps at most one element, so that every pop races with
+  // the thieves for it
+  for (i = 0; i < MAX_PUSH_POP; i++)
+    {
+      if (args->id == 0)
+        {
+          deque_push(deque, ELEMENT(0, i));
+          if (deque_pop(deque, &element) == 0 && take(element) != 0)
+            return (void*)-1;
+        }
+      else if (deque_steal(deque, &element) == 0 && take(element) != 0)
+        return (void*)-1;
+    }
+
+  return (void*)0;
+}
+
+int
+test_steal_empty()
+{
+  thread_test_args_t args[NB_THREADS];
+  int i;
+
+  memset(seen, 0, sizeof(seen));
+  taken = 0;
+
+  if (run_test_function(&thread_test_steal_empty, args) != 0)
+    return 0;
+
+  for (i = 0; i < MAX_PUSH_POP; i++)
+    if (seen[i] != 1)
+      return 0;
+
+  return taken == MAX_PUSH_POP && deque_size(deque) == 0;
+}
+
+// Deque performance test: every thread owns a deque, as workers of a
+// scheduler do
+#if MEASURE != 0
+struct deque_measure_arg
+{
+  int id;
+};
+typedef struct deque_measure_arg deque_measure_arg_t;
+
+struct timespec t_start[NB_THREADS], t_stop[NB_THREADS], start, stop;
+
+static deque_t *deques[NB_THREADS];
+
+static void
+measure_setup()
+{
+  int i;
+
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      deques[i] = deque_alloc(DEQUE_CAPACITY);
+#if MEASURE == 2 || MEASURE == 3
+      int j;
+
+      // Fill the deques for pop and steal measurements
+      for (j = 0; j < MAX_PUSH_POP / NB_THREADS; j++)
+        deque_push(deques[i], ELEMENT(i, j));
+#endif
+    }
+}
+
+static void*
+thread_test_performance(void* data)
+{
+  deque_measure_arg_t* arg = (deque_measure_arg_t*)data;
+  deque_t *own = deques[arg->id];
+#if MEASURE != 1
+  void *element;
+#endif
+  int i;
+
+  for (i = 0; i < MAX_PUSH_POP/NB_THREADS; i++)
+    {
+#if MEASURE == 1
+      if (deque_push(own, ELEMENT(arg->id, i)) != 0)
+        return (void*)-1;
+#elif MEASURE == 2
+      if (deque_pop(own, &element) != 0)
+        return (void*)-1;
+#else
+      // Push to the own deque and steal from the next one
+      if (i % 2 == 0)
+        deque_push(own, ELEMENT(arg->id, i));
+      else
+        deque_steal(deques[(arg->id + 1) % NB_THREADS], &element);
+#endif
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &t_stop[arg->id]);
+  return (void*)0;
+}
+#endif
+
+int
+main(int argc, char **argv)
+{
+setbuf(stdout, NULL);
+// MEASURE == 0 -> run unit tests
+#if MEASURE == 0
+  test_init();
+
+  test_run(test_lifo);
+  test_run(test_steal_fifo);
+  test_run(test_grow);
+  test_run(test_steal_safe);
+  test_run(test_steal_empty);
+
+  test_finalize();
+#else
+  // Run performance tests
+  int i;
+  deque_measure_arg_t arg[NB_THREADS];
+  pthread_attr_t attr;
+  pthread_t thread[NB_THREADS];
+
+  measure_setup();
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      arg[i].id = i;
+      clock_gettime(CLOCK_MONOTONIC, &t_start[i]);
+      pthread_create(&thread[i], &attr, &thread_test_performance, &arg[i]);
+    }
+
+  // Wait for all threads to finish
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      pthread_join(thread[i], NULL);
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+
+  // Print out results
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      printf("%i %i %li %i %li %i %li %i %li\n", i, (int) start.tv_sec,
+          start.tv_nsec, (int) stop.tv_sec, stop.tv_nsec,
+          (int) t_start[i].tv_sec, t_start[i].tv_nsec, (int) t_stop[i].tv_sec,
+          t_stop[i].tv_nsec);
+    }
+#endif
+
+  return 0;
+}
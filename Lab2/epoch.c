@@ -0,0 +1,277 @@
+/*
+ * epoch.c
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ *
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "epoch.h"
+#include "registry.h"
+#include "non_blocking.h"
+
+// Lower end of the reservation of a thread outside any critical section
+#define EPOCH_IDLE SIZE_MAX
+
+#define CACHE_LINE_SIZE 64
+
+struct retired
+{
+  void *ptr;
+  void (*release)(void*);
+  size_t birth;
+  size_t retire;
+};
+
+struct limbo_list
+{
+  struct retired *items;
+  size_t count;
+  size_t size;
+};
+
+struct reservation
+{
+  size_t lower;
+  size_t upper;
+};
+
+struct epoch_record
+{
+  volatile size_t lower;
+  volatile size_t upper;
+  struct limbo_list limbo;
+  // Length of the limbo list at which it is scanned next
+  size_t scan_at;
+  size_t retired;
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+volatile size_t epoch_global __attribute__((aligned(CACHE_LINE_SIZE)));
+__thread volatile size_t *epoch_upper;
+
+static struct epoch_record records[REGISTRY_MAX_THREADS];
+
+// Pointers left behind by exited threads, scanned along with the lists of
+// the threads still running
+static struct limbo_list orphans;
+static pthread_mutex_t orphans_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_once_t epoch_once = PTHREAD_ONCE_INIT;
+
+static void epoch_exit_thread(int id);
+
+static void
+epoch_init(void)
+{
+  int i;
+
+  for (i = 0; i < REGISTRY_MAX_THREADS; i++)
+    records[i].lower = EPOCH_IDLE;
+  registry_on_exit(epoch_exit_thread);
+}
+
+static struct epoch_record *
+epoch_record(void)
+{
+  pthread_once(&epoch_once, epoch_init);
+  return &records[registry_thread_id()];
+}
+
+static void
+limbo_list_append(struct limbo_list *list, const struct retired *item)
+{
+  if (list->count == list->size)
+  {
+    list->size = list->size == 0 ? EPOCH_ADVANCE_PERIOD : list->size * 2;
+    list->items = realloc(list->items, list->size * sizeof(struct retired));
+    if (list->items == NULL)
+    {
+      fprintf(stderr, "[ERROR] Cannot grow epoch limbo list\n");
+      abort();
+    }
+  }
+
+  list->items[list->count++] = *item;
+}
+
+// Release the pointers of list that no reservation covers, and keep the
+// others
+static void
+limbo_list_scan(struct limbo_list *list, const struct reservation *reservations,
+    int count)
+{
+  size_t i, kept = 0;
+  int r;
+
+  for (i = 0; i < list->count; i++)
+  {
+    struct retired *item = &list->items[i];
+
+    for (r = 0; r < count; r++)
+      if (reservations[r].lower <= item->retire && item->birth <= reservations[r].upper)
+        break;
+
+    if (r == count)
+      item->release(item->ptr);
+    else
+      list->items[kept++] = *item;
+  }
+  list->count = kept;
+}
+
+// Copy the reservations of the threads in a critical section. Returns how
+// many there are.
+static int
+epoch_reservations(struct reservation *reservations)
+{
+  int threads = registry_threads(), t, count = 0;
+  size_t lower;
+
+  // Either a reader sees the retired pointers unlinked, or its reservation
+  // is seen here; pairs with the fences of epoch_enter() and epoch_extend()
+  __sync_synchronize();
+  for (t = 0; t < threads; t++)
+  {
+    // The lower end is written last on entry, so the upper end read after
+    // it is at least as recent
+    lower = load_acquire((size_t*)&records[t].lower);
+    if (lower == EPOCH_IDLE)
+      continue;
+    reservations[count].lower = lower;
+    reservations[count].upper = records[t].upper;
+    count++;
+  }
+
+  return count;
+}
+
+// Release what the calling thread and the exited threads can
+static void
+epoch_scan(struct epoch_record *record)
+{
+  struct reservation reservations[REGISTRY_MAX_THREADS];
+  int count = epoch_reservations(reservations);
+
+  limbo_list_scan(&record->limbo, reservations, count);
+
+  // Scanning only again once as many pointers were retired as were kept
+  // makes the cost per retirement independent of how many a stalled
+  // thread holds back
+  record->scan_at = 2 * record->limbo.count;
+  if (record->scan_at < EPOCH_ADVANCE_PERIOD)
+    record->scan_at = EPOCH_ADVANCE_PERIOD;
+
+  if (orphans.count != 0)
+  {
+    pthread_mutex_lock(&orphans_lock);
+    limbo_list_scan(&orphans, reservations, count);
+    pthread_mutex_unlock(&orphans_lock);
+  }
+}
+
+void
+epoch_enter(void)
+{
+  struct epoch_record *record = epoch_record();
+  size_t epoch = epoch_global;
+
+  assert(record->lower == EPOCH_IDLE);
+
+  epoch_upper = &record->upper;
+  record->upper = epoch;
+  store_release((size_t*)&record->lower, epoch);
+  // The reservation must be visible before any shared node is read
+  __sync_synchronize();
+}
+
+void
+epoch_exit(void)
+{
+  struct epoch_record *record = epoch_record();
+
+  assert(record->lower != EPOCH_IDLE);
+
+  store_release((size_t*)&record->lower, EPOCH_IDLE);
+}
+
+void
+epoch_retire(void *ptr, size_t birth, void (*release)(void*))
+{
+  struct epoch_record *record = epoch_record();
+  struct retired item = { ptr, release, birth, 0 };
+
+  assert(record->lower == EPOCH_IDLE);
+
+  // No older than the unlinking of ptr, which precedes the call
+  __sync_synchronize();
+  item.retire = epoch_global;
+  limbo_list_append(&record->limbo, &item);
+
+  if (++record->retired % EPOCH_ADVANCE_PERIOD == 0)
+    __sync_fetch_and_add(&epoch_global, 1);
+
+  if (record->limbo.count >= record->scan_at)
+    epoch_scan(record);
+}
+
+size_t
+epoch_collect(void)
+{
+  struct epoch_record *record = epoch_record();
+
+  assert(record->lower == EPOCH_IDLE);
+
+  __sync_fetch_and_add(&epoch_global, 1);
+  epoch_scan(record);
+
+  return record->limbo.count;
+}
+
+static void
+epoch_exit_thread(int id)
+{
+  struct epoch_record *record = &records[id];
+  size_t i;
+
+  record->lower = EPOCH_IDLE;
+
+  if (record->limbo.count != 0)
+  {
+    pthread_mutex_lock(&orphans_lock);
+    for (i = 0; i < record->limbo.count; i++)
+      limbo_list_append(&orphans, &record->limbo.items[i]);
+    pthread_mutex_unlock(&orphans_lock);
+  }
+
+  free(record->limbo.items);
+  record->limbo.items = NULL;
+  record->limbo.count = 0;
+  record->limbo.size = 0;
+  record->scan_at = 0;
+  record->retired = 0;
+}
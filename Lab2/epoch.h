@@ -0,0 +1,102 @@
+/*
+ * epoch.h
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ *
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <stddef.h>
+
+#ifndef EPOCH_H_
+#define EPOCH_H_
+
+// Interval-based reclamation (H. Wen et al., 2018), a variant of epoch-based
+// reclamation (K. Fraser, 2004) in which a stalled thread cannot hold back
+// every retirement. Each node records the epoch it was allocated in, and a
+// thread in a critical section reserves the epochs from its entry to its
+// last read of a shared pointer. A pointer retired in epoch r is released
+// once no reservation meets the epochs from its birth to r. The epoch
+// advances with retirements whatever the readers do, so a thread stalled
+// in a critical section, e.g. preempted, holds back only the nodes that
+// already existed when it last read one: memory stays bounded, and no
+// thread ever waits for it.
+
+// Bracket every access to shared nodes that may be retired meanwhile.
+// Critical sections do not nest.
+void epoch_enter(void);
+void epoch_exit(void);
+
+// Retirements by a thread between two advances of the epoch
+#ifndef EPOCH_ADVANCE_PERIOD
+#define EPOCH_ADVANCE_PERIOD 64
+#endif
+
+extern volatile size_t epoch_global;
+extern __thread volatile size_t *epoch_upper;
+
+// Birth epoch of a node allocated now, to pass to epoch_retire()
+static inline __attribute__((always_inline)) size_t
+epoch_birth(void)
+{
+  return __atomic_load_n(&epoch_global, __ATOMIC_ACQUIRE);
+}
+
+// Extend the reservation of the calling thread to the current epoch.
+// Returns 1 if it had to, in which case pointers read since must be read
+// again, as nodes born meanwhile may have been released already.
+static inline __attribute__((always_inline)) int
+epoch_extend(void)
+{
+  size_t epoch = __atomic_load_n(&epoch_global, __ATOMIC_ACQUIRE);
+
+  if (*epoch_upper == epoch)
+    return 0;
+
+  // The reservation must be visible before the pointer is read again; pairs
+  // with the fence of the scan in epoch_retire()
+  *epoch_upper = epoch;
+  __sync_synchronize();
+
+  return 1;
+}
+
+// Read a shared pointer to a node that may be retired, before dereferencing
+// it within the critical section
+static inline __attribute__((always_inline)) size_t
+epoch_read(volatile size_t *src)
+{
+  size_t value;
+
+  do {
+    value = __atomic_load_n(src, __ATOMIC_ACQUIRE);
+  } while (epoch_extend());
+
+  return value;
+}
+
+// Hand ptr, allocated in epoch birth, over to release once no thread can
+// hold it anymore. Must be called outside a critical section, once ptr is
+// unreachable. Never waits.
+void epoch_retire(void *ptr, size_t birth, void (*release)(void*));
+
+// Advance the epoch and release what the calling thread can. Returns the
+// number of pointers of the calling thread still waiting.
+size_t epoch_collect(void);
+
+#endif /* EPOCH_H_ */
@@ -0,0 +1,219 @@
+/*
+ * hazard.c
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ *
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "hazard.h"
+#include "registry.h"
+
+// A thread scans its retired pointers once it holds that many times more
+// than there can be hazard slots in use. At least half of them are then
+// released, which amortizes each scan over as many retirements.
+#define HAZARD_SCAN_FACTOR 2
+#define HAZARD_SCAN_MIN 64
+
+#define CACHE_LINE_SIZE 64
+
+struct hazard_record
+{
+  void * volatile slot[HAZARD_SLOTS];
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+struct retired
+{
+  void *ptr;
+  void (*release)(void*);
+};
+
+struct retire_list
+{
+  struct retired *items;
+  size_t count;
+  size_t size;
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+static struct hazard_record records[REGISTRY_MAX_THREADS];
+static struct retire_list retired[REGISTRY_MAX_THREADS];
+
+// Pointers left behind by exited threads, adopted by the next scan
+static struct retire_list orphans;
+static pthread_mutex_t orphans_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_once_t hazard_once = PTHREAD_ONCE_INIT;
+
+static void hazard_exit(int id);
+
+static void
+hazard_init(void)
+{
+  registry_on_exit(hazard_exit);
+}
+
+static int
+hazard_thread_id(void)
+{
+  pthread_once(&hazard_once, hazard_init);
+  return registry_thread_id();
+}
+
+static void
+retire_list_append(struct retire_list *list, void *ptr, void (*release)(void*))
+{
+  if (list->count == list->size)
+  {
+    list->size = list->size == 0 ? HAZARD_SCAN_MIN : list->size * 2;
+    list->items = realloc(list->items, list->size * sizeof(struct retired));
+    if (list->items == NULL)
+    {
+      fprintf(stderr, "[ERROR] Cannot grow hazard pointer retire list\n");
+      abort();
+    }
+  }
+
+  list->items[list->count].ptr = ptr;
+  list->items[list->count].release = release;
+  list->count++;
+}
+
+void
+hazard_protect(int slot, void *ptr)
+{
+  assert(slot >= 0 && slot < HAZARD_SLOTS);
+
+  records[hazard_thread_id()].slot[slot] = ptr;
+  // The slot must be visible before the caller validates ptr
+  __sync_synchronize();
+}
+
+void
+hazard_clear(int slot)
+{
+  assert(slot >= 0 && slot < HAZARD_SLOTS);
+
+  __sync_synchronize();
+  records[hazard_thread_id()].slot[slot] = NULL;
+}
+
+static int
+compare_ptr(const void *a, const void *b)
+{
+  const char *x = *(void* const*)a, *y = *(void* const*)b;
+
+  return (x > y) - (x < y);
+}
+
+static size_t
+hazard_scan_list(struct retire_list *list)
+{
+  void *protected[REGISTRY_MAX_THREADS * HAZARD_SLOTS];
+  size_t nb_protected = 0, kept = 0, i;
+  int threads, t, s;
+
+  if (orphans.count != 0)
+  {
+    pthread_mutex_lock(&orphans_lock);
+    for (i = 0; i < orphans.count; i++)
+      retire_list_append(list, orphans.items[i].ptr, orphans.items[i].release);
+    orphans.count = 0;
+    pthread_mutex_unlock(&orphans_lock);
+  }
+
+  // Snapshot all hazard slots once, then look every retired pointer up
+  __sync_synchronize();
+  threads = registry_threads();
+  for (t = 0; t < threads; t++)
+    for (s = 0; s < HAZARD_SLOTS; s++)
+    {
+      void *ptr = records[t].slot[s];
+      if (ptr != NULL)
+        protected[nb_protected++] = ptr;
+    }
+  qsort(protected, nb_protected, sizeof(void*), compare_ptr);
+
+  for (i = 0; i < list->count; i++)
+  {
+    struct retired item = list->items[i];
+
+    if (bsearch(&item.ptr, protected, nb_protected, sizeof(void*), compare_ptr) != NULL)
+      list->items[kept++] = item;
+    else
+      item.release(item.ptr);
+  }
+  list->count = kept;
+
+  return kept;
+}
+
+void
+hazard_retire(void *ptr, void (*release)(void*))
+{
+  struct retire_list *list = &retired[hazard_thread_id()];
+  size_t threshold;
+
+  retire_list_append(list, ptr, release);
+
+  threshold = HAZARD_SCAN_FACTOR * HAZARD_SLOTS * registry_threads();
+  if (threshold < HAZARD_SCAN_MIN)
+    threshold = HAZARD_SCAN_MIN;
+
+  if (list->count >= threshold)
+    hazard_scan_list(list);
+}
+
+size_t
+hazard_scan(void)
+{
+  return hazard_scan_list(&retired[hazard_thread_id()]);
+}
+
+static void
+hazard_exit(int id)
+{
+  struct retire_list *list = &retired[id];
+  int s;
+  size_t i;
+
+  for (s = 0; s < HAZARD_SLOTS; s++)
+    records[id].slot[s] = NULL;
+
+  if (list->count != 0 && hazard_scan_list(list) != 0)
+  {
+    // Still protected by other threads; leave them to the next scan
+    pthread_mutex_lock(&orphans_lock);
+    for (i = 0; i < list->count; i++)
+      retire_list_append(&orphans, list->items[i].ptr, list->items[i].release);
+    pthread_mutex_unlock(&orphans_lock);
+  }
+
+  free(list->items);
+  list->items = NULL;
+  list->count = 0;
+  list->size = 0;
+}
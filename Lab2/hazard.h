@@ -0,0 +1,47 @@
+/*
+ * hazard.h
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ *
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stddef.h>
+
+#ifndef HAZARD_H_
+#define HAZARD_H_
+
+// Hazard pointers (M. Michael, 2004). A thread publishes the nodes it is
+// about to dereference in its hazard slots; retired nodes are only given
+// back to their release function once no slot points to them anymore.
+
+// Number of hazard slots of each thread
+#define HAZARD_SLOTS 2
+
+// Publish ptr in the calling thread's slot. The caller must check that ptr
+// is still reachable after this call before dereferencing it.
+void hazard_protect(int slot, void *ptr);
+void hazard_clear(int slot);
+
+// Hand ptr over to release once no thread protects it anymore
+void hazard_retire(void *ptr, void (*release)(void*));
+
+// Release every retired pointer of the calling thread that is not
+// protected anymore. Returns the number of pointers still waiting.
+size_t hazard_scan(void);
+
+#endif /* HAZARD_H_ */
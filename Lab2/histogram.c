@@ -0,0 +1,110 @@
+/*
+ * histogram.c
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ * 
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ * 
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ * 
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+
+#include <stdio.h>
+
+#include "histogram.h"
+
+unsigned long
+histogram_bucket_value(unsigned int bucket)
+{
+  unsigned int exponent;
+
+  if (bucket < HISTOGRAM_SUB_BUCKETS)
+    return bucket;
+
+  exponent = (bucket >> HISTOGRAM_SUB_BITS) + HISTOGRAM_SUB_BITS - 1;
+  return ((bucket & (HISTOGRAM_SUB_BUCKETS - 1)) + HISTOGRAM_SUB_BUCKETS)
+      << (exponent - HISTOGRAM_SUB_BITS);
+}
+
+void
+histogram_merge(struct histogram *dst, const struct histogram *src)
+{
+  unsigned int i;
+
+  if (src->count == 0)
+    return;
+
+  if (dst->count == 0 || src->min < dst->min)
+    dst->min = src->min;
+  if (src->max > dst->max)
+    dst->max = src->max;
+  dst->count += src->count;
+  dst->sum += src->sum;
+  for (i = 0; i < HISTOGRAM_BUCKETS; i++)
+    dst->buckets[i] += src->buckets[i];
+}
+
+unsigned long
+histogram_percentile(const struct histogram *histogram, double percent)
+{
+  unsigned long rank, seen = 0;
+  unsigned int i;
+
+  if (histogram->count == 0)
+    return 0;
+
+  rank = (unsigned long)(percent / 100 * histogram->count + 0.5);
+  if (rank == 0)
+    rank = 1;
+
+  for (i = 0; i < HISTOGRAM_BUCKETS; i++)
+  {
+    seen += histogram->buckets[i];
+    if (seen >= rank)
+      break;
+  }
+
+  // The largest value of the bucket, but never more than was recorded
+  if (i + 1 < HISTOGRAM_BUCKETS && histogram_bucket_value(i + 1) - 1 < histogram->max)
+    return histogram_bucket_value(i + 1) - 1;
+  return histogram->max;
+}
+
+void
+histogram_print_json(FILE *out, const struct histogram *histogram)
+{
+  unsigned int i;
+  int first = 1;
+
+  fprintf(out, "{\"count\": %lu, \"min\": %lu, \"mean\": %.1f, "
+      "\"p50\": %lu, \"p90\": %lu, \"p99\": %lu, \"p999\": %lu, \"max\": %lu, "
+      "\"buckets\": [",
+      histogram->count, histogram->min,
+      histogram->count > 0 ? (double)histogram->sum / histogram->count : 0.0,
+      histogram_percentile(histogram, 50), histogram_percentile(histogram, 90),
+      histogram_percentile(histogram, 99), histogram_percentile(histogram, 99.9),
+      histogram->max);
+
+  // Pairs of the smallest value of a bucket and its count
+  for (i = 0; i < HISTOGRAM_BUCKETS; i++)
+    if (histogram->buckets[i] != 0)
+    {
+      fprintf(out, "%s[%lu, %lu]", first ? "" : ", ", histogram_bucket_value(i),
+          histogram->buckets[i]);
+      first = 0;
+    }
+
+  fprintf(out, "]}");
+}
@@ -0,0 +1,88 @@
+/*
+ * histogram.h
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ * 
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ * 
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ * 
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+
+#include <stdio.h>
+
+#ifndef HISTOGRAM_H_
+#define HISTOGRAM_H_
+
+// Log-linear histogram in the manner of HdrHistogram. Every power of two
+// is split into 2^HISTOGRAM_SUB_BITS buckets, so that any 64-bit value is
+// counted with a relative error below 2^-HISTOGRAM_SUB_BITS in a fixed
+// number of buckets, and recording is a few instructions.
+
+#ifndef HISTOGRAM_SUB_BITS
+#define HISTOGRAM_SUB_BITS 4
+#endif
+#define HISTOGRAM_SUB_BUCKETS (1UL << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS ((64 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS)
+
+struct histogram
+{
+  unsigned long count;
+  unsigned long sum;
+  unsigned long min;
+  unsigned long max;
+  unsigned long buckets[HISTOGRAM_BUCKETS];
+};
+
+static inline unsigned int
+histogram_bucket(unsigned long value)
+{
+  unsigned int exponent;
+
+  if (value < HISTOGRAM_SUB_BUCKETS)
+    return value;
+
+  // Keep the HISTOGRAM_SUB_BITS bits below the leading one
+  exponent = 63 - __builtin_clzl(value);
+  return ((exponent - HISTOGRAM_SUB_BITS + 1) << HISTOGRAM_SUB_BITS)
+      + (value >> (exponent - HISTOGRAM_SUB_BITS)) - HISTOGRAM_SUB_BUCKETS;
+}
+
+static inline void
+histogram_record(struct histogram *histogram, unsigned long value)
+{
+  if (histogram->count == 0 || value < histogram->min)
+    histogram->min = value;
+  if (value > histogram->max)
+    histogram->max = value;
+  histogram->count++;
+  histogram->sum += value;
+  histogram->buckets[histogram_bucket(value)]++;
+}
+
+// Smallest value counted in a bucket
+unsigned long histogram_bucket_value(unsigned int bucket);
+
+// Add the values of src to dst
+void histogram_merge(struct histogram *dst, const struct histogram *src);
+
+// Value below which the given percentage of the values lie, up to the
+// bucket precision
+unsigned long histogram_percentile(const struct histogram *histogram, double percent);
+
+// Summary and non-empty buckets as a JSON object
+void histogram_print_json(FILE *out, const struct histogram *histogram);
+
+#endif /* HISTOGRAM_H_ */
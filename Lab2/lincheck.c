@@ -0,0 +1,738 @@
+/*
+ * lincheck.c
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ * 
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ * 
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ * 
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+
+// Randomized linearizability checker for the containers of the library.
+// Threads run a few random operations per round on a fresh container and
+// record when each operation was invoked and when it returned. After every
+// round, the history is searched for a linearization (Wing & Gong): an
+// order of the operations that respects real time, i.e. puts an operation
+// after every operation that returned before it was invoked, and in which
+// a sequential model of the container gives the same results. A round
+// without one is a violation, and its history is printed. Build with
+// PERTURB=n to make every CAS yield once in n calls, which lets many more
+// interleavings happen within a round.
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "stack.h"
+#include "queue.h"
+#include "ring.h"
+#include "deque.h"
+#include "skiplist.h"
+#include "backoff.h"
+
+// The operations done in a round are a 64-bit set
+#define MAX_OPS 64
+#define MAX_THREADS 16
+
+#define DEFAULT_OPS 6
+#define DEFAULT_ROUNDS 2000
+
+// Small enough for rounds to fill the ring and to grow the deque
+#define RING_CAPACITY 4
+#define DEQUE_CAPACITY 2
+// Keys of the skip list, few enough for operations to conflict
+#define SET_KEYS 4
+
+// Results of failed operations
+#define FAIL ((size_t)-1)
+#define ABORT ((size_t)-2)
+
+enum op_type { PUT, GET, STEAL, FIND };
+static const char *op_names[] = { "put", "get", "steal", "find" };
+
+struct op
+{
+  int thread;
+  enum op_type type;
+  size_t arg;      // value put, or key of a set
+  size_t result;   // value got, 0 for a successful put or find, or FAIL
+  unsigned long long invoke, response;
+};
+
+// State of a sequential container: its elements from first to last, or
+// the set of its keys as a bit mask in items[0]
+struct model
+{
+  size_t count;
+  size_t items[MAX_OPS];
+};
+
+struct container
+{
+  const char *name;
+  void * (*create)(void);
+  void   (*destroy)(void *container);
+  // Run a random operation for thread and record its type, argument and
+  // result; value is unique to this operation
+  void   (*run)(void *container, struct op *op, unsigned int random, size_t value);
+  // Apply op to the model; returns 0 if its result is impossible there
+  int    (*apply)(struct model *model, const struct op *op);
+};
+
+static unsigned long long
+now(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+// Models
+
+static int
+model_push(struct model *model, const struct op *op)
+{
+  if (op->result != 0)
+    return 0;
+  model->items[model->count++] = op->arg;
+  return 1;
+}
+
+static int
+model_pop_last(struct model *model, const struct op *op)
+{
+  if (model->count == 0)
+    return op->result == FAIL;
+  if (op->result != model->items[model->count - 1])
+    return 0;
+  // Clear what is popped, so that equal states hash alike
+  model->items[--model->count] = 0;
+  return 1;
+}
+
+static int
+model_pop_first(struct model *model, const struct op *op)
+{
+  if (model->count == 0)
+    return op->result == FAIL;
+  if (op->result != model->items[0])
+    return 0;
+  model->count--;
+  memmove(model->items, model->items + 1, model->count * sizeof(size_t));
+  model->items[model->count] = 0;
+  return 1;
+}
+
+static int
+stack_apply(struct model *model, const struct op *op)
+{
+  return op->type == PUT ? model_push(model, op) : model_pop_last(model, op);
+}
+
+static int
+queue_apply(struct model *model, const struct op *op)
+{
+  return op->type == PUT ? model_push(model, op) : model_pop_first(model, op);
+}
+
+// A ring operation may fail while another thread has claimed a slot but
+// not yet filled or emptied it, so failures are only checked to be
+// harmless; successful operations must still be in FIFO order.
+static int
+ring_apply(struct model *model, const struct op *op)
+{
+  if (op->result == FAIL)
+    return 1;
+  if (op->type == PUT && model->count == RING_CAPACITY)
+    return 0;
+  return queue_apply(model, op);
+}
+
+// The owner works at the end of the model, thieves at its beginning; a
+// thief losing a race changes nothing
+static int
+deque_apply(struct model *model, const struct op *op)
+{
+  switch (op->type)
+  {
+  case PUT:
+    return model_push(model, op);
+  case GET:
+    return model_pop_last(model, op);
+  default:
+    return op->result == ABORT || model_pop_first(model, op);
+  }
+}
+
+static int
+set_apply(struct model *model, const struct op *op)
+{
+  size_t bit = (size_t)1 << op->arg;
+  int present = (model->items[0] & bit) != 0;
+
+  switch (op->type)
+  {
+  case PUT:
+    model->items[0] |= bit;
+    return op->result == (present ? FAIL : 0);
+  case GET:
+    model->items[0] &= ~bit;
+    return op->result == (present ? 0 : FAIL);
+  default:
+    return op->result == (present ? 0 : FAIL);
+  }
+}
+
+// Containers
+
+static void *
+lin_stack_create(void)
+{
+  return stack_alloc();
+}
+
+static void
+lin_stack_destroy(void *container)
+{
+  stack_node_t *node;
+
+  while (stack_pop(container, &node) == 0)
+    stack_node_free(node);
+  stack_free(container);
+}
+
+static void
+lin_stack_run(void *container, struct op *op, unsigned int random, size_t value)
+{
+  stack_node_t *node;
+
+  if (random % 2 == 0)
+  {
+    op->type = PUT;
+    op->arg = value;
+    node = stack_node_alloc();
+    node->data = (void*)value;
+    op->invoke = now();
+    op->result = stack_push(container, node) == 0 ? 0 : FAIL;
+  }
+  else
+  {
+    op->type = GET;
+    op->invoke = now();
+    if (stack_pop(container, &node) == 0)
+    {
+      op->result = (size_t)node->data;
+      stack_node_free(node);
+    }
+    else
+      op->result = FAIL;
+  }
+  op->response = now();
+}
+
+static void *
+lin_queue_create(void)
+{
+  return queue_alloc();
+}
+
+static void
+lin_queue_destroy(void *container)
+{
+  queue_free(container);
+}
+
+static void
+lin_queue_run(void *container, struct op *op, unsigned int random, size_t value)
+{
+  void *data;
+
+  op->invoke = now();
+  if (random % 2 == 0)
+  {
+    op->type = PUT;
+    op->arg = value;
+    op->result = queue_enqueue(container, (void*)value) == 0 ? 0 : FAIL;
+  }
+  else
+  {
+    op->type = GET;
+    op->result = queue_dequeue(container, &data) == 0 ? (size_t)data : FAIL;
+  }
+  op->response = now();
+}
+
+static void *
+lin_ring_create(void)
+{
+  return ring_alloc(RING_CAPACITY);
+}
+
+static void
+lin_ring_destroy(void *container)
+{
+  ring_free(container);
+}
+
+static void
+lin_ring_run(void *container, struct op *op, unsigned int random, size_t value)
+{
+  void *data;
+
+  op->invoke = now();
+  if (random % 2 == 0)
+  {
+    op->type = PUT;
+    op->arg = value;
+    op->result = ring_enqueue(container, (void*)value) == 0 ? 0 : FAIL;
+  }
+  else
+  {
+    op->type = GET;
+    op->result = ring_dequeue(container, &data) == 0 ? (size_t)data : FAIL;
+  }
+  op->response = now();
+}
+
+static void *
+lin_deque_create(void)
+{
+  return deque_alloc(DEQUE_CAPACITY);
+}
+
+static void
+lin_deque_destroy(void *container)
+{
+  deque_free(container);
+}
+
+// Thread 0 owns the deque, the others steal
+static void
+lin_deque_run(void *container, struct op *op, unsigned int random, size_t value)
+{
+  void *data;
+  int result;
+
+  op->invoke = now();
+  if (op->thread != 0)
+  {
+    op->type = STEAL;
+    result = deque_steal(container, &data);
+    op->result = result == 0 ? (size_t)data : result == DEQUE_ABORT ? ABORT : FAIL;
+  }
+  else if (random % 2 == 0)
+  {
+    op->type = PUT;
+    op->arg = value;
+    op->result = deque_push(container, (void*)value) == 0 ? 0 : FAIL;
+  }
+  else
+  {
+    op->type = GET;
+    op->result = deque_pop(container, &data) == 0 ? (size_t)data : FAIL;
+  }
+  op->response = now();
+}
+
+static void *
+lin_skiplist_create(void)
+{
+  return skiplist_alloc();
+}
+
+static void
+lin_skiplist_destroy(void *container)
+{
+  skiplist_free(container);
+}
+
+static void
+lin_skiplist_run(void *container, struct op *op, unsigned int random, size_t value)
+{
+  op->arg = (random >> 8) % SET_KEYS;
+  op->invoke = now();
+  switch (random % 3)
+  {
+  case 0:
+    op->type = PUT;
+    op->result = skiplist_insert(container, op->arg, (void*)value) == 0 ? 0 : FAIL;
+    break;
+  case 1:
+    op->type = GET;
+    op->result = skiplist_remove(container, op->arg, NULL) == 0 ? 0 : FAIL;
+    break;
+  default:
+    op->type = FIND;
+    op->result = skiplist_find(container, op->arg, NULL) == 0 ? 0 : FAIL;
+  }
+  op->response = now();
+}
+
+static const struct container containers[] =
+{
+  { "stack", lin_stack_create, lin_stack_destroy, lin_stack_run, stack_apply },
+  { "queue", lin_queue_create, lin_queue_destroy, lin_queue_run, queue_apply },
+  { "ring", lin_ring_create, lin_ring_destroy, lin_ring_run, ring_apply },
+  { "deque", lin_deque_create, lin_deque_destroy, lin_deque_run, deque_apply },
+  { "skiplist", lin_skiplist_create, lin_skiplist_destroy, lin_skiplist_run, set_apply },
+};
+#define NB_CONTAINERS (sizeof(containers) / sizeof(struct container))
+
+// Search for a linearization
+
+// Cache of the sets of done operations and states already found to lead
+// nowhere, so that the search does not explore them again. Entries of
+// older rounds count as empty; when the slots probed are taken, the last
+// one is overwritten, which only costs exploring its state again.
+#define MEMO_BITS 18
+#define MEMO_SIZE (1 << MEMO_BITS)
+#define MEMO_PROBES 8
+
+// Histories with many overlapping operations can take exponential time to
+// check; rounds whose search takes more steps are counted as undecided
+#define DEFAULT_BUDGET 10000000UL
+
+struct memo_entry
+{
+  uint64_t done;
+  uint64_t state;
+  unsigned long round;
+};
+
+struct check
+{
+  const struct container *container;
+  struct op *ops;
+  int nb_ops;
+  unsigned long round;
+  unsigned long steps, budget;
+  struct memo_entry memo[MEMO_SIZE];
+};
+
+static uint64_t
+model_hash(const struct model *model)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  size_t i;
+
+  // FNV-1a over the elements, and over the first one at least, which
+  // holds the keys of sets
+  hash = (hash ^ model->count) * 1099511628211ULL;
+  for (i = 0; i < model->count || i == 0; i++)
+    hash = (hash ^ model->items[i]) * 1099511628211ULL;
+
+  return hash;
+}
+
+// Returns 0 if the pair was already visited in this round
+static int
+memo_insert(struct check *check, uint64_t done, uint64_t state)
+{
+  size_t i = (size_t)((done * 0x9e3779b97f4a7c15ULL ^ state) >> (64 - MEMO_BITS));
+  struct memo_entry *entry = NULL;
+  size_t probes;
+
+  for (probes = 0; probes < MEMO_PROBES; probes++, i = (i + 1) % MEMO_SIZE)
+  {
+    entry = &check->memo[i];
+    if (entry->round != check->round)
+      break;
+    if (entry->done == done && entry->state == state)
+      return 0;
+  }
+
+  entry->done = done;
+  entry->state = state;
+  entry->round = check->round;
+  return 1;
+}
+
+// Returns 1 if the operations not in done can be linearized from model, 0
+// if they cannot, and -1 if the budget ran out
+static int
+linearize(struct check *check, uint64_t done, const struct model *model)
+{
+  unsigned long long first_response = ~0ULL;
+  struct model next;
+  int i, found;
+
+  if (done == (check->nb_ops == 64 ? ~0ULL : (1ULL << check->nb_ops) - 1))
+    return 1;
+  if (++check->steps > check->budget)
+    return -1;
+
+  // Operations invoked before every pending operation returned can go next
+  for (i = 0; i < check->nb_ops; i++)
+    if (!(done & 1ULL << i) && check->ops[i].response < first_response)
+      first_response = check->ops[i].response;
+
+  for (i = 0; i < check->nb_ops; i++)
+  {
+    if ((done & 1ULL << i) || check->ops[i].invoke > first_response)
+      continue;
+
+    next = *model;
+    if (!check->container->apply(&next, &check->ops[i])
+        || !memo_insert(check, done | 1ULL << i, model_hash(&next)))
+      continue;
+
+    found = linearize(check, done | 1ULL << i, &next);
+    if (found != 0)
+      return found;
+  }
+
+  return 0;
+}
+
+static int
+compare_invoke(const void *a, const void *b)
+{
+  const struct op *x = a, *y = b;
+
+  return x->invoke < y->invoke ? -1 : x->invoke > y->invoke;
+}
+
+static void
+print_history(struct op *ops, int nb_ops)
+{
+  unsigned long long origin;
+  int i;
+
+  qsort(ops, nb_ops, sizeof(struct op), compare_invoke);
+  origin = ops[0].invoke;
+
+  printf("# thread op arg result invoke_ns response_ns\n");
+  for (i = 0; i < nb_ops; i++)
+    printf("%i %s %zi %zi %llu %llu\n", ops[i].thread, op_names[ops[i].type],
+        (ssize_t)ops[i].arg, (ssize_t)ops[i].result, ops[i].invoke - origin,
+        ops[i].response - origin);
+}
+
+// Rounds
+
+struct round
+{
+  const struct container *container;
+  void *instance;
+  int nb_ops;
+  volatile int done;
+  pthread_barrier_t start, stop;
+  struct op ops[MAX_OPS];
+};
+
+struct worker
+{
+  pthread_t thread;
+  int id;
+  struct round *round;
+};
+
+static void*
+worker_run(void *arg)
+{
+  struct worker *worker = arg;
+  struct round *round = worker->round;
+  unsigned int x = 2654435761u * (worker->id + 1), spins;
+  size_t seq = 0;
+  int i;
+
+  for (;;)
+  {
+    pthread_barrier_wait(&round->start);
+    if (round->done)
+      break;
+
+    for (i = 0; i < round->nb_ops; i++)
+    {
+      struct op *op = &round->ops[worker->id * round->nb_ops + i];
+
+      // xorshift
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+
+      // Vary the start of operations, so that they overlap differently
+      for (spins = x >> 26; spins > 0; spins--)
+        cpu_relax();
+
+      op->thread = worker->id;
+      op->arg = 0;
+      round->container->run(round->instance, op, x, ++seq << 8 | worker->id);
+    }
+
+    pthread_barrier_wait(&round->stop);
+  }
+
+  return NULL;
+}
+
+// Returns the number of rounds without linearization, and counts in
+// undecided those the search gave up on
+static unsigned long
+check_container(const struct container *container, int threads, int ops,
+    unsigned long rounds, unsigned long budget, unsigned long *undecided)
+{
+  static struct check check;
+  static struct round round;
+  struct worker workers[MAX_THREADS];
+  struct model empty;
+  unsigned long r, violations = 0;
+  int t, found;
+
+  round.container = container;
+  round.nb_ops = ops;
+  round.done = 0;
+  pthread_barrier_init(&round.start, NULL, threads + 1);
+  pthread_barrier_init(&round.stop, NULL, threads + 1);
+  for (t = 0; t < threads; t++)
+  {
+    workers[t].id = t;
+    workers[t].round = &round;
+    pthread_create(&workers[t].thread, NULL, worker_run, &workers[t]);
+  }
+
+  check.container = container;
+  check.ops = round.ops;
+  check.nb_ops = threads * ops;
+  check.budget = budget;
+  memset(&empty, 0, sizeof(empty));
+  *undecided = 0;
+
+  for (r = 0; r < rounds; r++)
+  {
+    round.instance = container->create();
+    pthread_barrier_wait(&round.start);
+    pthread_barrier_wait(&round.stop);
+    container->destroy(round.instance);
+
+    check.round++;
+    check.steps = 0;
+    found = linearize(&check, 0, &empty);
+    if (found < 0)
+      (*undecided)++;
+    else if (found == 0)
+    {
+      if (violations++ == 0)
+      {
+        printf("# %s: round %lu has no linearization\n", container->name, r);
+        print_history(round.ops, check.nb_ops);
+      }
+    }
+  }
+
+  round.done = 1;
+  pthread_barrier_wait(&round.start);
+  for (t = 0; t < threads; t++)
+    pthread_join(workers[t].thread, NULL);
+  pthread_barrier_destroy(&round.start);
+  pthread_barrier_destroy(&round.stop);
+
+  return violations;
+}
+
+static int
+container_selected(const struct container *container, const char *list)
+{
+  const char *found;
+  size_t length = strlen(container->name);
+
+  if (list == NULL)
+    return 1;
+
+  for (found = strstr(list, container->name); found != NULL; found = strstr(found + 1, container->name))
+    if ((found == list || found[-1] == ',') && (found[length] == ',' || found[length] == '\0'))
+      return 1;
+
+  return 0;
+}
+
+static void
+usage(const char *name)
+{
+  unsigned int i;
+
+  fprintf(stderr, "Usage: %s [-c containers] [-t threads] [-o operations per thread] "
+      "[-r rounds] [-b search steps per round]\n"
+      "Threads times operations must not exceed %i.\nContainers:",
+      name, MAX_OPS);
+  for (i = 0; i < NB_CONTAINERS; i++)
+    fprintf(stderr, " %s", containers[i].name);
+  fprintf(stderr, "\n");
+}
+
+int
+main(int argc, char **argv)
+{
+  unsigned long rounds = DEFAULT_ROUNDS, budget = DEFAULT_BUDGET, violations,
+      undecided, failed = 0;
+  int threads = NB_THREADS, ops = DEFAULT_OPS, opt;
+  const char *only = NULL;
+  unsigned int c;
+
+  while ((opt = getopt(argc, argv, "c:t:o:r:b:")) != -1)
+  {
+    switch (opt)
+    {
+    case 'c':
+      only = optarg;
+      break;
+    case 't':
+      threads = atoi(optarg);
+      break;
+    case 'o':
+      ops = atoi(optarg);
+      break;
+    case 'r':
+      rounds = strtoul(optarg, NULL, 10);
+      break;
+    case 'b':
+      budget = strtoul(optarg, NULL, 10);
+      break;
+    default:
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (threads < 1 || threads > MAX_THREADS || ops < 1 || threads * ops > MAX_OPS
+      || rounds == 0 || budget == 0)
+  {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  printf("# container threads operations rounds violations undecided\n");
+  for (c = 0; c < NB_CONTAINERS; c++)
+  {
+    if (!container_selected(&containers[c], only))
+      continue;
+
+    violations = check_container(&containers[c], threads, ops, rounds, budget,
+        &undecided);
+    printf("%s %i %i %lu %lu %lu\n", containers[c].name, threads, ops, rounds,
+        violations, undecided);
+    failed += violations;
+  }
+
+  return failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -27,32 +27,93 @@
 
 #include <stddef.h>
 
-#if NON_BLOCKING == 0 || NON_BLOCKING == 1
-#include <pthread.h>
+#include "non_blocking.h"
+#include "backoff.h"
+
+// The bit masks of software_casn() have one bit per stripe
+#if SOFTWARE_CAS_STRIPES > 64
+#error SOFTWARE_CAS_STRIPES must be at most 64
 #endif
 
-#if NON_BLOCKING == 1
-#include <string.h>
+static struct software_cas_stripe
+{
+  volatile int lock;
+} __attribute__((aligned(64))) stripes[SOFTWARE_CAS_STRIPES];
+
+static unsigned int
+software_cas_stripe(size_t *reg)
+{
+  // Fibonacci hashing of the word index, keeping its top six bits
+  return (unsigned int)((((size_t)reg / sizeof(size_t)) * (size_t)0x9e3779b97f4a7c15ULL)
+      >> (8 * sizeof(size_t) - 6)) % SOFTWARE_CAS_STRIPES;
+}
+
+static void
+software_cas_lock(unsigned int stripe)
+{
+  volatile int *lock = &stripes[stripe].lock;
+
+  // Test and test-and-set, so that waiting threads only read the line
+  while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE) != 0)
+    while (*lock != 0)
+      cpu_relax();
+}
+
+static void
+software_cas_unlock(unsigned int stripe)
+{
+  __atomic_store_n(&stripes[stripe].lock, 0, __ATOMIC_RELEASE);
+}
 
-inline size_t
-software_cas(size_t* reg, size_t oldval, size_t newval, pthread_mutex_t *lock)
+size_t
+software_cas(size_t* reg, size_t oldval, size_t newval)
 {
+  unsigned int stripe = software_cas_stripe(reg);
   size_t val;
 
-  pthread_mutex_lock(lock);
+  perturb();
+  software_cas_lock(stripe);
   val = *reg;
   if (val == oldval)
-    *reg = newval;
-  pthread_mutex_unlock(lock);
+    *(volatile size_t*)reg = newval;
+  software_cas_unlock(stripe);
 
   return val;
 }
-#endif
+
+int
+software_casn(size_t n, size_t * const *regs, const size_t *oldvals,
+    const size_t *newvals)
+{
+  unsigned long long mask = 0, left;
+  size_t i;
+  int success = 1;
+
+  perturb();
+
+  // Several words may share a stripe, which is then locked once
+  for (i = 0; i < n; i++)
+    mask |= 1ULL << software_cas_stripe(regs[i]);
+
+  for (left = mask; left != 0; left &= left - 1)
+    software_cas_lock(__builtin_ctzll(left));
+
+  for (i = 0; i < n && success; i++)
+    success = *regs[i] == oldvals[i];
+  if (success)
+    for (i = 0; i < n; i++)
+      *(volatile size_t*)regs[i] = newvals[i];
+
+  for (left = mask; left != 0; left &= left - 1)
+    software_cas_unlock(__builtin_ctzll(left));
+
+  return success;
+}
 
 #if defined i386 || __i386__ || __i486__ || __i586__ || __i686__ || __i386 || __IA32__ || _M_IX86 || _M_IX86 || __X86__ || _X86_ || __THW_INTEL__ || __I86__ || __INTEL__ || __x86_64 || __x86_64__
 
-inline size_t
-cas(size_t* reg, size_t oldval, size_t newval)
+size_t
+cas_asm(size_t* reg, size_t oldval, size_t newval)
 {
   /*int out;
 
@@ -81,8 +142,8 @@ cas(size_t* reg, size_t oldval, size_t newval)
 #else
 #ifdef __GNUC__
 
-inline size_t
-cas(size_t* reg, size_t oldval, size_t newval)
+size_t
+cas_asm(size_t* reg, size_t oldval, size_t newval)
 {
   return __sync_val_compare_and_swap(reg, oldval, newval);
 }
@@ -90,8 +151,8 @@ cas(size_t* reg, size_t oldval, size_t newval)
 #else
 
 #warning Unsupported compiler and architecture; no CAS available
-inline size_t
-cas(size_t* reg, size_t oldval, size_t newval)
+size_t
+cas_asm(size_t* reg, size_t oldval, size_t newval)
 {
   return 0;
 }
@@ -99,3 +160,57 @@ cas(size_t* reg, size_t oldval, size_t newval)
 #endif
 #endif
 
+#if defined __x86_64 || __x86_64__
+
+tagged_ptr_t
+cas2(tagged_ptr_t* reg, tagged_ptr_t oldval, tagged_ptr_t newval)
+{
+  perturb();
+
+  // Compares rdx:rax to *reg; stores rcx:rbx in *reg if equal, else loads
+  // *reg to rdx:rax. Either way rdx:rax ends with the previous value.
+  asm volatile( "lock; cmpxchg16b %0":
+                "+m"(*reg), "+a"(oldval.ptr), "+d"(oldval.tag):
+                "b"(newval.ptr), "c"(newval.tag):
+                "memory", "cc" );
+
+  return oldval;
+}
+
+#else
+#ifdef __GNUC__
+
+union tagged_word
+{
+  tagged_ptr_t tagged;
+#if __SIZEOF_SIZE_T__ == 8
+  unsigned __int128 word;
+#else
+  unsigned long long word;
+#endif
+};
+
+tagged_ptr_t
+cas2(tagged_ptr_t* reg, tagged_ptr_t oldval, tagged_ptr_t newval)
+{
+  union tagged_word old_word, new_word, res;
+
+  perturb();
+  old_word.tagged = oldval;
+  new_word.tagged = newval;
+  res.word = __sync_val_compare_and_swap(&((union tagged_word*)reg)->word, old_word.word, new_word.word);
+
+  return res.tagged;
+}
+
+#else
+
+#warning Unsupported compiler and architecture; no double-width CAS available
+tagged_ptr_t
+cas2(tagged_ptr_t* reg, tagged_ptr_t oldval, tagged_ptr_t newval)
+{
+  return *reg;
+}
+
+#endif
+#endif
@@ -26,15 +26,127 @@
 #ifndef NON_BLOCKING_H_
 #define NON_BLOCKING_H_
 
-// Alias for pointer-sized CAS
-#define cas(reg, old, new) cas(reg, old, new)
+// Pointer-sized CAS, returning the previous value of *reg. It is inlined
+// at call sites through the compiler's atomic builtins, which map to lock
+// cmpxchg on x86 and to LL/SC or LSE instructions on AArch64. CAS_ASM=1
+// selects the former out-of-line assembly implementation instead, with
+// a full fence for every variant.
+size_t cas_asm(size_t*, size_t, size_t);
 
-size_t cas(size_t*, size_t, size_t);
+#define ALWAYS_INLINE static inline __attribute__((always_inline))
 
-#if NON_BLOCKING == 1
-#include <pthread.h>
+// Schedule perturbation for stress tests. With PERTURB=n, every CAS first
+// yields the processor once in n calls on average, so that other threads
+// run between the reads a CAS depends on and the CAS itself. Costs nothing
+// with PERTURB=0.
+#ifndef PERTURB
+#define PERTURB 0
+#endif
+
+#if PERTURB
+#include <sched.h>
+
+static __thread unsigned int perturb_seed;
+
+ALWAYS_INLINE void
+perturb(void)
+{
+  unsigned int x = perturb_seed;
+
+  if (x == 0)
+    x = 2654435761u * (unsigned int)(size_t)&perturb_seed | 1;
+
+  // xorshift
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  perturb_seed = x;
+
+  if (x % PERTURB == 0)
+    sched_yield();
+}
+#else
+#define perturb() ((void)0)
+#endif
+
+#if CAS_ASM
+#define cas(reg, old, new) (perturb(), cas_asm(reg, old, new))
+#define cas_acquire(reg, old, new) (perturb(), cas_asm(reg, old, new))
+#define cas_release(reg, old, new) (perturb(), cas_asm(reg, old, new))
+#else
+ALWAYS_INLINE size_t
+cas(size_t *reg, size_t oldval, size_t newval)
+{
+  perturb();
+  __atomic_compare_exchange_n(reg, &oldval, newval, 0, __ATOMIC_ACQ_REL,
+      __ATOMIC_ACQUIRE);
+  return oldval;
+}
 
-size_t software_cas(size_t *, size_t, size_t, pthread_mutex_t*);
+// Orders later accesses after the CAS, e.g. to take ownership of a node
+ALWAYS_INLINE size_t
+cas_acquire(size_t *reg, size_t oldval, size_t newval)
+{
+  perturb();
+  __atomic_compare_exchange_n(reg, &oldval, newval, 0, __ATOMIC_ACQUIRE,
+      __ATOMIC_ACQUIRE);
+  return oldval;
+}
+
+// Orders earlier accesses before the CAS, e.g. to publish a node
+ALWAYS_INLINE size_t
+cas_release(size_t *reg, size_t oldval, size_t newval)
+{
+  perturb();
+  __atomic_compare_exchange_n(reg, &oldval, newval, 0, __ATOMIC_RELEASE,
+      __ATOMIC_RELAXED);
+  return oldval;
+}
 #endif
 
+ALWAYS_INLINE size_t
+load_acquire(size_t *reg)
+{
+  return __atomic_load_n(reg, __ATOMIC_ACQUIRE);
+}
+
+ALWAYS_INLINE void
+store_release(size_t *reg, size_t val)
+{
+  __atomic_store_n(reg, val, __ATOMIC_RELEASE);
+}
+
+// Pointer and modification counter, swapped together by cas2()
+struct tagged_ptr
+{
+  size_t ptr;
+  size_t tag;
+} __attribute__((aligned(2 * sizeof(size_t))));
+typedef struct tagged_ptr tagged_ptr_t;
+
+static inline int
+tagged_ptr_equal(tagged_ptr_t a, tagged_ptr_t b)
+{
+  return a.ptr == b.ptr && a.tag == b.tag;
+}
+
+// Double-width CAS of a pointer and its tag; returns the previous value
+tagged_ptr_t cas2(tagged_ptr_t*, tagged_ptr_t, tagged_ptr_t);
+
+// CAS emulated with locks, for targets without a native CAS of the needed
+// width. Addresses are hashed to a fixed array of spinlocks, each on its
+// own cache line, so that unrelated words rarely share a lock. A word
+// updated with software CAS must only be written through software CAS or
+// CASN; plain reads are fine.
+#define SOFTWARE_CAS_STRIPES 64
+
+size_t software_cas(size_t *reg, size_t oldval, size_t newval);
+
+// Multi-word CAS: if every *regs[i] equals oldvals[i], set each of them to
+// newvals[i], atomically with respect to other software CAS and CASN
+// operations. Stripes are locked in a fixed order, so CASNs never
+// deadlock. Returns 1 on success, 0 if a word differed.
+int software_casn(size_t n, size_t * const *regs, const size_t *oldvals,
+    const size_t *newvals);
+
 #endif /* NON_BLOCKING_H_ */
@@ -0,0 +1,196 @@
+/*
+ * park.h
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ *
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#else
+#include <sched.h>
+#endif
+
+#ifndef PARK_H_
+#define PARK_H_
+
+// Parking lot for threads waiting for a condition, such as a non-empty
+// stack (an eventcount). A waiter takes a ticket, checks its condition
+// again and sleeps on a futex until the ticket is outdated. Whoever makes
+// the condition true only makes a system call if somebody sleeps.
+//
+//   ticket = park_prepare(&park);
+//   if (condition) park_cancel(&park); else park_wait(&park, ticket, deadline);
+//
+// and on the other side: make the condition true, then park_wake_one().
+// The condition must be made true by an atomic read-modify-write, such as
+// the CAS of a push, or under a lock that the waiter's check takes too, so
+// that it is ordered before the waker reads how many threads sleep.
+
+struct park
+{
+  volatile int seq;
+  volatile int sleepers;
+  // Calls of park_interrupt() so far
+  volatile int interrupts;
+};
+
+// Orders the read-modify-write that made the condition true before the load
+// of sleepers, against park_prepare(). Locked instructions are full barriers
+// on x86, so only the compiler is held back there; elsewhere a release-only
+// CAS needs a fence.
+#if defined(__x86_64__) || defined(__i386__)
+#define park_after_rmw() __asm__ __volatile__("" ::: "memory")
+#else
+#define park_after_rmw() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
+
+static inline void
+park_init(struct park *park)
+{
+  park->seq = 0;
+  park->sleepers = 0;
+  park->interrupts = 0;
+}
+
+// Absolute deadline timeout_us microseconds from now
+static inline void
+park_deadline(struct timespec *deadline, long timeout_us)
+{
+  clock_gettime(CLOCK_MONOTONIC, deadline);
+  deadline->tv_sec += timeout_us / 1000000;
+  deadline->tv_nsec += (timeout_us % 1000000) * 1000;
+  if (deadline->tv_nsec >= 1000000000)
+  {
+    deadline->tv_sec++;
+    deadline->tv_nsec -= 1000000000;
+  }
+}
+
+static inline int
+park_prepare(struct park *park)
+{
+  int ticket = __atomic_load_n(&park->seq, __ATOMIC_ACQUIRE);
+
+  // Full barrier: the condition is checked again only after wakers can
+  // see this thread
+  __sync_fetch_and_add(&park->sleepers, 1);
+
+  return ticket;
+}
+
+static inline void
+park_cancel(struct park *park)
+{
+  __sync_fetch_and_sub(&park->sleepers, 1);
+}
+
+// Sleep until woken after the ticket was taken, or until deadline if not
+// NULL. Spurious returns are possible, so the caller checks its condition
+// again. Returns -1 once the deadline has passed.
+static inline int
+park_wait(struct park *park, int ticket, const struct timespec *deadline)
+{
+  struct timespec now, left, *timeout = NULL;
+  int expired = 0;
+
+  if (deadline != NULL)
+  {
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    left.tv_sec = deadline->tv_sec - now.tv_sec;
+    left.tv_nsec = deadline->tv_nsec - now.tv_nsec;
+    if (left.tv_nsec < 0)
+    {
+      left.tv_sec--;
+      left.tv_nsec += 1000000000;
+    }
+    expired = left.tv_sec < 0;
+    timeout = &left;
+  }
+
+  if (!expired && park->seq == ticket)
+  {
+#ifdef __linux__
+    syscall(SYS_futex, &park->seq, FUTEX_WAIT_PRIVATE, ticket, timeout, NULL, 0);
+#else
+    sched_yield();
+#endif
+  }
+  park_cancel(park);
+
+  if (deadline != NULL && !expired)
+  {
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    expired = now.tv_sec > deadline->tv_sec
+        || (now.tv_sec == deadline->tv_sec && now.tv_nsec >= deadline->tv_nsec);
+  }
+
+  return expired ? -1 : 0;
+}
+
+static inline void
+park_wake(struct park *park, int count)
+{
+  // Pairs with the barrier of park_prepare(); nothing more than the
+  // read-modify-write that made the condition true on x86, so pushes
+  // nobody waits for cost one load
+  park_after_rmw();
+  if (park->sleepers == 0)
+    return;
+
+  __sync_fetch_and_add(&park->seq, 1);
+#ifdef __linux__
+  syscall(SYS_futex, &park->seq, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+#endif
+}
+
+static inline void
+park_wake_one(struct park *park)
+{
+  park_wake(park, 1);
+}
+
+static inline void
+park_wake_all(struct park *park)
+{
+  park_wake(park, INT_MAX);
+}
+
+// Number of interrupts so far; waiters take it before checking their
+// condition the first time and stop once it changed
+static inline int
+park_interrupts(struct park *park)
+{
+  return __atomic_load_n(&park->interrupts, __ATOMIC_ACQUIRE);
+}
+
+// Wake every waiter and tell them to stop waiting, e.g. when there is no
+// more work to wait for
+static inline void
+park_interrupt(struct park *park)
+{
+  __sync_fetch_and_add(&park->interrupts, 1);
+  park_wake_all(park);
+}
+
+#endif /* PARK_H_ */
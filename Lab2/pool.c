@@ -0,0 +1,244 @@
+/*
+ * pool.c
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ *
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "pool.h"
+#include "registry.h"
+#include "non_blocking.h"
+
+#define POOL_MAX 8
+
+#define CACHE_LINE_SIZE 64
+
+// Free objects are linked through their first word; the first object of a
+// batch in the global list links to the next batch with its second word
+struct pool_object
+{
+  struct pool_object *next;
+  struct pool_object *next_batch;
+};
+
+struct pool_cache
+{
+  struct pool_object *free;
+  size_t count;
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+struct pool
+{
+  // Tagged, as batches are taken and given back all the time (ABA problem)
+  tagged_ptr_t batches;
+  size_t object_size;
+  unsigned long slabs, refills, returns;
+  struct pool_cache caches[REGISTRY_MAX_THREADS];
+};
+
+static pool_t *pools[POOL_MAX];
+static size_t nb_pools;
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+
+static void pool_exit(int id);
+
+static void
+pool_init(void)
+{
+  registry_on_exit(pool_exit);
+}
+
+pool_t *
+pool_create(size_t object_size)
+{
+  pool_t *pool;
+  size_t slot;
+
+  assert(object_size >= sizeof(struct pool_object));
+
+  pthread_once(&pool_once, pool_init);
+
+  if (posix_memalign((void**)&pool, CACHE_LINE_SIZE, sizeof(struct pool)) != 0)
+    return NULL;
+  memset(pool, 0, sizeof(struct pool));
+
+  // Keep every object aligned to a pointer
+  pool->object_size = (object_size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+
+  slot = __sync_fetch_and_add(&nb_pools, 1);
+  if (slot >= POOL_MAX)
+  {
+    fprintf(stderr, "[ERROR] More than %i pools\n", POOL_MAX);
+    abort();
+  }
+  pools[slot] = pool;
+
+  return pool;
+}
+
+static void
+pool_push_batch(pool_t *pool, struct pool_object *batch)
+{
+  tagged_ptr_t head, new_head;
+
+  new_head.ptr = (size_t)batch;
+  do {
+    head = pool->batches;
+    batch->next_batch = (struct pool_object*)head.ptr;
+    new_head.tag = head.tag + 1;
+  } while (!tagged_ptr_equal(cas2(&pool->batches, head, new_head), head));
+
+  __sync_fetch_and_add(&pool->returns, 1);
+}
+
+static struct pool_object *
+pool_pop_batch(pool_t *pool)
+{
+  tagged_ptr_t head, new_head;
+  struct pool_object *batch;
+
+  // Batches are never freed, so reading next_batch of a batch taken by
+  // another thread meanwhile is harmless; the tag makes the CAS fail then
+  do {
+    head = pool->batches;
+    batch = (struct pool_object*)head.ptr;
+    if (batch == NULL)
+      return NULL;
+    new_head.ptr = (size_t)batch->next_batch;
+    new_head.tag = head.tag + 1;
+  } while (!tagged_ptr_equal(cas2(&pool->batches, head, new_head), head));
+
+  __sync_fetch_and_add(&pool->refills, 1);
+
+  return batch;
+}
+
+static struct pool_object *
+pool_new_slab(pool_t *pool)
+{
+  char *slab;
+  size_t i;
+
+  // Slabs start on a cache line so that objects do not straddle two lines
+  // more than their size requires
+  if (posix_memalign((void**)&slab, CACHE_LINE_SIZE, POOL_BATCH * pool->object_size) != 0)
+  {
+    fprintf(stderr, "[ERROR] Cannot allocate pool slab\n");
+    abort();
+  }
+
+  for (i = 0; i < POOL_BATCH; i++)
+  {
+    struct pool_object *object = (struct pool_object*)(slab + i * pool->object_size);
+    object->next = i + 1 < POOL_BATCH ?
+        (struct pool_object*)(slab + (i + 1) * pool->object_size) : NULL;
+  }
+
+  __sync_fetch_and_add(&pool->slabs, 1);
+
+  return (struct pool_object*)slab;
+}
+
+void *
+pool_alloc(pool_t *pool)
+{
+  struct pool_cache *cache = &pool->caches[registry_thread_id()];
+  struct pool_object *object;
+
+  if (cache->free == NULL)
+  {
+    struct pool_object *batch = pool_pop_batch(pool);
+
+    if (batch == NULL)
+      batch = pool_new_slab(pool);
+
+    cache->free = batch;
+    // Batches given back by exiting threads may be shorter
+    for (cache->count = 0; batch != NULL; batch = batch->next)
+      cache->count++;
+  }
+
+  object = cache->free;
+  cache->free = object->next;
+  cache->count--;
+
+  return object;
+}
+
+void
+pool_free(pool_t *pool, void *ptr)
+{
+  struct pool_cache *cache = &pool->caches[registry_thread_id()];
+  struct pool_object *object = ptr, *last;
+  size_t i;
+
+  object->next = cache->free;
+  cache->free = object;
+  cache->count++;
+
+  // Keep one batch at hand for the next allocations, give back another one
+  if (cache->count >= 2 * POOL_BATCH)
+  {
+    for (i = 1, last = cache->free; i < POOL_BATCH; i++)
+      last = last->next;
+
+    cache->free = last->next;
+    cache->count -= POOL_BATCH;
+    last->next = NULL;
+    pool_push_batch(pool, object);
+  }
+}
+
+void
+pool_get_stats(pool_t *pool, struct pool_stats *stats)
+{
+  stats->slabs = pool->slabs;
+  stats->refills = pool->refills;
+  stats->returns = pool->returns;
+}
+
+static void
+pool_exit(int id)
+{
+  size_t i;
+
+  for (i = 0; i < nb_pools && i < POOL_MAX; i++)
+  {
+    struct pool_cache *cache;
+
+    if (pools[i] == NULL)
+      continue;
+
+    cache = &pools[i]->caches[id];
+    if (cache->free != NULL)
+      pool_push_batch(pools[i], cache->free);
+    cache->free = NULL;
+    cache->count = 0;
+  }
+}
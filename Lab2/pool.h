@@ -0,0 +1,56 @@
+/*
+ * pool.h
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ *
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <stddef.h>
+
+#ifndef POOL_H_
+#define POOL_H_
+
+// Pool of fixed-size objects. Every thread allocates from and frees to its
+// own cache without synchronization. Caches refill from and overflow to a
+// global lock-free list of batches, and only allocate new slabs from malloc
+// when that list is empty. Memory is never given back to malloc.
+
+// Number of objects in a batch moved between caches and the global list
+#ifndef POOL_BATCH
+#define POOL_BATCH 256
+#endif
+
+struct pool_stats
+{
+  unsigned long slabs;    // slabs of POOL_BATCH objects taken from malloc
+  unsigned long refills;  // batches taken from the global list
+  unsigned long returns;  // batches given to the global list
+};
+
+typedef struct pool pool_t;
+
+// Objects are at least two pointers large and aligned to a pointer
+pool_t * pool_create(size_t object_size);
+
+void *   pool_alloc(pool_t *pool);
+void     pool_free(pool_t *pool, void *object);
+
+void     pool_get_stats(pool_t *pool, struct pool_stats *stats);
+
+#endif /* POOL_H_ */
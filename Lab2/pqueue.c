@@ -0,0 +1,259 @@
+/*
+ * pqueue.c
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ * 
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ * 
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ * 
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "pqueue.h"
+#include "backoff.h"
+
+#define CACHE_LINE_SIZE 64
+
+// Capacity of a heap when it first grows
+#define PQUEUE_HEAP_MIN 64
+
+struct pqueue_entry
+{
+  size_t priority;
+  void *data;
+};
+
+// Binary min-heap. Its size and minimum are kept next to the lock, so that
+// deletions can compare heaps without locking them.
+struct pqueue_heap
+{
+  volatile size_t lock;
+  volatile size_t size;
+  volatile size_t min;
+  size_t capacity;
+  struct pqueue_entry *entries;
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+struct pqueue
+{
+  size_t nb_heaps;
+  struct pqueue_heap *heaps;
+};
+
+static __thread unsigned int heap_seed;
+
+static size_t
+pqueue_random_heap(pqueue_t *queue)
+{
+  unsigned int x = heap_seed;
+
+  if (x == 0)
+    x = 2654435761u * (unsigned int)(size_t)&heap_seed | 1;
+
+  // xorshift
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  heap_seed = x;
+
+  return x % queue->nb_heaps;
+}
+
+// Never waits for a heap: a thread finding it locked picks another one
+static int
+pqueue_heap_trylock(struct pqueue_heap *heap)
+{
+  return heap->lock == 0 && __sync_lock_test_and_set(&heap->lock, 1) == 0;
+}
+
+static void
+pqueue_heap_unlock(struct pqueue_heap *heap)
+{
+  heap->min = heap->size > 0 ? heap->entries[0].priority : 0;
+  __sync_lock_release(&heap->lock);
+}
+
+static int
+pqueue_heap_push(struct pqueue_heap *heap, size_t priority, void *data)
+{
+  struct pqueue_entry entry = { priority, data };
+  size_t i = heap->size, parent;
+
+  if (heap->size == heap->capacity)
+  {
+    size_t capacity = heap->capacity > 0 ? 2 * heap->capacity : PQUEUE_HEAP_MIN;
+    struct pqueue_entry *entries = realloc(heap->entries,
+        capacity * sizeof(struct pqueue_entry));
+
+    if (entries == NULL)
+      return -1;
+    heap->entries = entries;
+    heap->capacity = capacity;
+  }
+
+  // Sift up
+  for (; i > 0 && heap->entries[parent = (i - 1) / 2].priority > priority; i = parent)
+    heap->entries[i] = heap->entries[parent];
+  heap->entries[i] = entry;
+  heap->size++;
+
+  return 0;
+}
+
+static struct pqueue_entry
+pqueue_heap_pop(struct pqueue_heap *heap)
+{
+  struct pqueue_entry top = heap->entries[0], last;
+  size_t i = 0, child, size = --heap->size;
+
+  // Sift the last entry down from the root
+  last = heap->entries[size];
+  while ((child = 2 * i + 1) < size)
+  {
+    if (child + 1 < size && heap->entries[child + 1].priority < heap->entries[child].priority)
+      child++;
+    if (heap->entries[child].priority >= last.priority)
+      break;
+    heap->entries[i] = heap->entries[child];
+    i = child;
+  }
+  heap->entries[i] = last;
+
+  return top;
+}
+
+pqueue_t *
+pqueue_alloc(size_t heaps)
+{
+  pqueue_t *queue;
+  size_t i;
+
+  if (heaps == 0)
+    heaps = PQUEUE_FACTOR * sysconf(_SC_NPROCESSORS_ONLN);
+
+  queue = malloc(sizeof(pqueue_t));
+  if (queue == NULL)
+    return NULL;
+  if (posix_memalign((void**)&queue->heaps, CACHE_LINE_SIZE, heaps * sizeof(struct pqueue_heap)) != 0)
+  {
+    free(queue);
+    return NULL;
+  }
+
+  for (i = 0; i < heaps; i++)
+  {
+    queue->heaps[i].lock = 0;
+    queue->heaps[i].size = 0;
+    queue->heaps[i].min = 0;
+    queue->heaps[i].capacity = 0;
+    queue->heaps[i].entries = NULL;
+  }
+  queue->nb_heaps = heaps;
+
+  return queue;
+}
+
+int
+pqueue_free(pqueue_t *queue)
+{
+  size_t i;
+
+  for (i = 0; i < queue->nb_heaps; i++)
+    free(queue->heaps[i].entries);
+  free(queue->heaps);
+  free(queue);
+
+  return 0;
+}
+
+size_t
+pqueue_heaps(pqueue_t *queue)
+{
+  return queue->nb_heaps;
+}
+
+int
+pqueue_insert(pqueue_t *queue, size_t priority, void *data)
+{
+  struct pqueue_heap *heap;
+  struct backoff backoff;
+  int result;
+
+  backoff_init(&backoff);
+  while (!pqueue_heap_trylock(heap = &queue->heaps[pqueue_random_heap(queue)]))
+    backoff_retry(&backoff);
+
+  result = pqueue_heap_push(heap, priority, data);
+  pqueue_heap_unlock(heap);
+
+  return result;
+}
+
+int
+pqueue_delete_min(pqueue_t *queue, size_t *priority, void **data)
+{
+  struct pqueue_heap *heap, *other;
+  struct pqueue_entry entry;
+  struct backoff backoff;
+  size_t i;
+
+  backoff_init(&backoff);
+  for (;;)
+  {
+    // Two choices: the heap with the smaller minimum, or the non-empty one
+    heap = &queue->heaps[pqueue_random_heap(queue)];
+    other = &queue->heaps[pqueue_random_heap(queue)];
+    if (heap->size == 0 || (other->size > 0 && other->min < heap->min))
+      heap = other;
+
+    if (heap->size == 0)
+    {
+      // Both were empty; give up only if all heaps are
+      for (i = 0; i < queue->nb_heaps && queue->heaps[i].size == 0; i++)
+        ;
+      if (i == queue->nb_heaps)
+        return -1;
+      heap = &queue->heaps[i];
+    }
+
+    if (pqueue_heap_trylock(heap))
+    {
+      // The heap may have been emptied before it was locked
+      if (heap->size > 0)
+        break;
+      pqueue_heap_unlock(heap);
+    }
+    backoff_retry(&backoff);
+  }
+
+  entry = pqueue_heap_pop(heap);
+  pqueue_heap_unlock(heap);
+
+  if (priority != NULL)
+    *priority = entry.priority;
+  if (data != NULL)
+    *data = entry.data;
+
+  return 0;
+}
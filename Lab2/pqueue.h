@@ -0,0 +1,55 @@
+/*
+ * pqueue.h
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ * 
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ * 
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ * 
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+#include <stddef.h>
+
+#ifndef PQUEUE_H_
+#define PQUEUE_H_
+
+// Relaxed concurrent priority queue (MultiQueue, Rihani, Sanders &
+// Dementiev 2015). Elements are spread over several sequential heaps, each
+// behind its own lock; inserts go to a random heap, and deletions take the
+// smaller minimum of two random heaps. Deletions thus return an element
+// close to the minimum rather than the minimum itself: the expected rank
+// of the element returned grows with the number of heaps, not with the
+// number of elements. With a single heap, the queue is exact.
+
+// Heaps per processor when pqueue_alloc() is given no number of heaps
+#ifndef PQUEUE_FACTOR
+#define PQUEUE_FACTOR 2
+#endif
+
+typedef struct pqueue pqueue_t;
+
+// Use PQUEUE_FACTOR heaps per online processor if heaps is 0
+pqueue_t * pqueue_alloc(size_t heaps);
+// Not thread-safe: no other operation may run on the queue
+int        pqueue_free(pqueue_t *queue);
+
+size_t     pqueue_heaps(pqueue_t *queue);
+
+// Lower priorities come out first. Returns -1 if memory is exhausted.
+int        pqueue_insert(pqueue_t *queue, size_t priority, void *data);
+// Returns -1 if the queue looked empty; priority and data may be NULL
+int        pqueue_delete_min(pqueue_t *queue, size_t *priority, void **data);
+
+#endif /* PQUEUE_H_ */
@@ -0,0 +1,400 @@
+/*
+ * pqueue_test.c
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ * 
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ * 
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ * 
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include <sched.h>
+
+#include "pqueue.h"
+
+#define test_run(test)\
+  printf("[%s:%s:%i] Running test '%s'... ", __FILE__, __FUNCTION__, __LINE__, #test);\
+  test_setup();\
+  if(test())\
+  {\
+    printf("passed\n");\
+  }\
+  else\
+  {\
+    printf("failed\n");\
+  }\
+  test_teardown();
+
+// Data are derived from their priority, so that deletions can check them
+#define DATA(priority) ((void*)((size_t)(priority) * 2 + 1))
+
+// Elements of the tests
+#define NB_ELEMENTS (NB_THREADS * MAX_PUSH_POP)
+// Elements of the rank error test, which is quadratic
+#define NB_RANKED (NB_ELEMENTS < 4096 ? NB_ELEMENTS : 4096)
+
+static pqueue_t *queue;
+
+void
+test_init()
+{
+  // Initialize your test batch
+}
+
+void
+test_setup()
+{
+  // Allocate and initialize your test queue before each test
+  queue = pqueue_alloc(0);
+
+#if MEASURE == 2 || MEASURE == 3
+  int i;
+
+  // Fill the queue for deletion measurements
+  for (i = 0; i < (MEASURE == 2 ? MAX_PUSH_POP : MAX_PUSH_POP / 2); i++)
+    pqueue_insert(queue, (i * 7919) % MAX_PUSH_POP, DATA((i * 7919) % MAX_PUSH_POP));
+#endif
+}
+
+void
+test_teardown()
+{
+  pqueue_free(queue);
+}
+
+void
+test_finalize()
+{
+  // Destroy properly your test batch
+}
+
+struct thread_test_args
+{
+  int id;
+  size_t count;
+};
+typedef struct thread_test_args thread_test_args_t;
+
+static int
+run_test_function(void* (*func)(void* arg), thread_test_args_t *args)
+{
+  pthread_attr_t attr;
+  pthread_t thread[NB_THREADS];
+
+  int i;
+  int result = 0;
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      args[i].id = i;
+      args[i].count = 0;
+      pthread_create(&thread[i], &attr, func, &args[i]);
+    }
+
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      void *ret;
+      pthread_join(thread[i], &ret);
+      if (ret != 0)
+        result = -1;
+    }
+
+  return result;
+}
+
+static int seen[NB_ELEMENTS];
+
+// Delete everything left and check that every priority below count came
+// out exactly once overall
+static int
+check_drained(size_t count)
+{
+  size_t priority, i;
+  void *data;
+
+  while (pqueue_delete_min(queue, &priority, &data) == 0)
+    {
+      if (priority >= count || data != DATA(priority))
+        return 0;
+      seen[priority]++;
+    }
+
+  for (i = 0; i < count; i++)
+    if (seen[i] != 1)
+      return 0;
+
+  return 1;
+}
+
+int
+test_exact()
+{
+  size_t priority, i;
+  void *data;
+
+  // A single heap is an exact priority queue
+  pqueue_free(queue);
+  queue = pqueue_alloc(1);
+
+  for (i = 0; i < 1000; i++)
+    pqueue_insert(queue, (i * 7919) % 1000, DATA((i * 7919) % 1000));
+
+  for (i = 0; i < 1000; i++)
+    if (pqueue_delete_min(queue, &priority, &data) != 0 || priority != i || data != DATA(i))
+      return 0;
+
+  return pqueue_delete_min(queue, NULL, NULL) == -1;
+}
+
+int
+test_relaxed()
+{
+  size_t priority, i, heaps = pqueue_heaps(queue), rank_error = 0;
+
+  memset(seen, 0, sizeof(seen));
+
+  for (i = 0; i < NB_RANKED; i++)
+    pqueue_insert(queue, i, DATA(i));
+
+  // Deletions return elements near the minimum: the number of smaller
+  // elements still queued stays far below the size of the queue on
+  // average. It is about the number of heaps in theory; the bound leaves
+  // room for unlucky choices.
+  for (i = 0; i < NB_RANKED / 2; i++)
+    {
+      size_t smaller = 0, j;
+
+      if (pqueue_delete_min(queue, &priority, NULL) != 0)
+        return 0;
+      seen[priority]++;
+      for (j = 0; j < priority; j++)
+        smaller += seen[j] == 0;
+      rank_error += smaller;
+    }
+
+  return rank_error / (NB_RANKED / 2) <= 8 * heaps && check_drained(NB_RANKED);
+}
+
+static void*
+thread_test_insert(void* arg)
+{
+  thread_test_args_t *args = arg;
+  size_t i;
+
+  for (i = args->id; i < NB_ELEMENTS; i += NB_THREADS)
+    if (pqueue_insert(queue, i, DATA(i)) != 0)
+      return (void*)-1;
+
+  return (void*)0;
+}
+
+int
+test_insert_safe()
+{
+  thread_test_args_t args[NB_THREADS];
+
+  // Make sure no element is lost when several threads insert concurrently
+  memset(seen, 0, sizeof(seen));
+  if (run_test_function(&thread_test_insert, args) != 0)
+    return 0;
+
+  return check_drained(NB_ELEMENTS);
+}
+
+static void*
+thread_test_delete(void* arg)
+{
+  thread_test_args_t *args = arg;
+  size_t priority;
+  void *data;
+
+  while (pqueue_delete_min(queue, &priority, &data) == 0)
+    {
+      if (priority >= NB_ELEMENTS || data != DATA(priority))
+        return (void*)-1;
+      __sync_fetch_and_add(&seen[priority], 1);
+      args->count++;
+    }
+
+  return (void*)0;
+}
+
+int
+test_delete_safe()
+{
+  thread_test_args_t args[NB_THREADS];
+  size_t i;
+
+  // Every element is deleted by exactly one thread
+  memset(seen, 0, sizeof(seen));
+  for (i = 0; i < NB_ELEMENTS; i++)
+    pqueue_insert(queue, i, DATA(i));
+
+  if (run_test_function(&thread_test_delete, args) != 0)
+    return 0;
+
+  return check_drained(NB_ELEMENTS);
+}
+
+static void*
+thread_test_mixed(void* arg)
+{
+  thread_test_args_t *args = arg;
+  size_t i, priority;
+  void *data;
+
+  // Every insert is followed by a deletion, so the queue is never empty
+  // for long, although a deletion may scan the heaps while elements move
+  // between those it already checked and the others
+  for (i = args->id; i < NB_ELEMENTS; i += NB_THREADS)
+    {
+      if (pqueue_insert(queue, i, DATA(i)) != 0)
+        return (void*)-1;
+      while (pqueue_delete_min(queue, &priority, &data) != 0)
+        sched_yield();
+      if (priority >= NB_ELEMENTS || data != DATA(priority))
+        return (void*)-1;
+      __sync_fetch_and_add(&seen[priority], 1);
+    }
+
+  return (void*)0;
+}
+
+int
+test_mixed()
+{
+  thread_test_args_t args[NB_THREADS];
+
+  memset(seen, 0, sizeof(seen));
+  if (run_test_function(&thread_test_mixed, args) != 0)
+    return 0;
+
+  return check_drained(NB_ELEMENTS);
+}
+
+// Priority queue performance test
+#if MEASURE != 0
+struct pqueue_measure_arg
+{
+  int id;
+};
+typedef struct pqueue_measure_arg pqueue_measure_arg_t;
+
+struct timespec t_start[NB_THREADS], t_stop[NB_THREADS], start, stop;
+
+static void*
+thread_test_performance(void* data)
+{
+  pqueue_measure_arg_t* arg = (pqueue_measure_arg_t*)data;
+#if MEASURE != 2
+  size_t priority;
+#endif
+  int i;
+
+  for (i = 0; i < MAX_PUSH_POP/NB_THREADS; i++)
+    {
+#if MEASURE != 2
+      priority = ((size_t)i * NB_THREADS + arg->id) * 7919 % MAX_PUSH_POP;
+#endif
+#if MEASURE == 1
+      if (pqueue_insert(queue, priority, DATA(priority)) != 0)
+        return (void*)-1;
+#elif MEASURE == 2
+      if (pqueue_delete_min(queue, NULL, NULL) != 0)
+        return (void*)-1;
+#else
+      // Alternate insert and deletion
+      if (i % 2 == 0 ? pqueue_insert(queue, priority, DATA(priority)) != 0 :
+          pqueue_delete_min(queue, NULL, NULL) != 0)
+        return (void*)-1;
+#endif
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &t_stop[arg->id]);
+  return (void*)0;
+}
+#endif
+
+int
+main(int argc, char **argv)
+{
+setbuf(stdout, NULL);
+// MEASURE == 0 -> run unit tests
+#if MEASURE == 0
+  test_init();
+
+  test_run(test_exact);
+  test_run(test_relaxed);
+  test_run(test_insert_safe);
+  test_run(test_delete_safe);
+  test_run(test_mixed);
+
+  test_finalize();
+#else
+  // Run performance tests
+  int i;
+  pqueue_measure_arg_t arg[NB_THREADS];
+  pthread_attr_t attr;
+  pthread_t thread[NB_THREADS];
+
+  test_setup();
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      arg[i].id = i;
+      clock_gettime(CLOCK_MONOTONIC, &t_start[i]);
+      pthread_create(&thread[i], &attr, &thread_test_performance, &arg[i]);
+    }
+
+  // Wait for all threads to finish
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      pthread_join(thread[i], NULL);
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+
+  // Print out results
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      printf("%i %i %li %i %li %i %li %i %li\n", i, (int) start.tv_sec,
+          start.tv_nsec, (int) stop.tv_sec, stop.tv_nsec,
+          (int) t_start[i].tv_sec, t_start[i].tv_nsec, (int) t_stop[i].tv_sec,
+          t_stop[i].tv_nsec);
+    }
+#endif
+
+  return 0;
+}
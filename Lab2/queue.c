@@ -0,0 +1,322 @@
+/*
+ * queue.c
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ * 
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ * 
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ * 
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#include <assert.h>
+#include <pthread.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "queue.h"
+#include "non_blocking.h"
+#include "backoff.h"
+
+#if NODE_POOL
+#include "pool.h"
+#endif
+
+#if RECLAIM == 2
+#include "epoch.h"
+#else
+#include "hazard.h"
+#endif
+
+#define CACHE_LINE_SIZE 64
+
+struct queue_node
+{
+  void *data;
+  struct queue_node * volatile next;
+#if RECLAIM == 2
+  // Epoch the node was allocated in, see epoch.h
+  size_t birth;
+#endif
+};
+typedef struct queue_node queue_node_t;
+
+// The head always points to a dummy node, whose successor holds the first
+// element; the tail points to the last node or, while an enqueue is half
+// done, to the one before. Both are written by different threads, so they
+// are kept on separate cache lines.
+struct queue
+{
+  queue_node_t * volatile head __attribute__((aligned(CACHE_LINE_SIZE)));
+  queue_node_t * volatile tail __attribute__((aligned(CACHE_LINE_SIZE)));
+};
+
+#if NODE_POOL
+static pool_t *node_pool;
+static pthread_once_t node_pool_once = PTHREAD_ONCE_INIT;
+
+static void
+node_pool_init(void)
+{
+  node_pool = pool_create(sizeof(queue_node_t));
+}
+#endif
+
+static queue_node_t *
+queue_node_alloc(void *data)
+{
+  queue_node_t *node;
+
+#if NODE_POOL
+  if (node_pool == NULL)
+    pthread_once(&node_pool_once, node_pool_init);
+  node = pool_alloc(node_pool);
+#else
+  node = malloc(sizeof(queue_node_t));
+#endif
+  if (node == NULL)
+    return NULL;
+
+  node->data = data;
+  node->next = NULL;
+#if RECLAIM == 2
+  node->birth = epoch_birth();
+#endif
+
+  return node;
+}
+
+static void
+queue_node_release(void *node)
+{
+#if NODE_POOL
+  pool_free(node_pool, node);
+#else
+  free(node);
+#endif
+}
+
+static void
+queue_node_retire(queue_node_t *node)
+{
+#if RECLAIM == 2
+  epoch_retire(node, node->birth, queue_node_release);
+#else
+  hazard_retire(node, queue_node_release);
+#endif
+}
+
+// Read a node pointer and make sure the node is not freed before the end
+// of the operation, as long as src still points to it when checked
+static queue_node_t *
+queue_protect(int slot, queue_node_t * volatile *src)
+{
+  queue_node_t *node;
+
+#if RECLAIM == 2
+  node = (queue_node_t*)epoch_read((size_t*)src);
+#else
+  do {
+    node = *src;
+    hazard_protect(slot, node);
+  } while (node != *src);
+#endif
+
+  return node;
+}
+
+static void
+queue_enter(void)
+{
+#if RECLAIM == 2
+  epoch_enter();
+#endif
+}
+
+static void
+queue_leave(void)
+{
+#if RECLAIM == 2
+  epoch_exit();
+#else
+  hazard_clear(1);
+  hazard_clear(0);
+#endif
+}
+
+queue_t *
+queue_alloc(void)
+{
+  queue_t *queue;
+  queue_node_t *dummy;
+
+  if (posix_memalign((void**)&queue, CACHE_LINE_SIZE, sizeof(struct queue)) != 0)
+    return NULL;
+
+  dummy = queue_node_alloc(NULL);
+  if (dummy == NULL)
+  {
+    free(queue);
+    return NULL;
+  }
+
+  queue->head = dummy;
+  queue->tail = dummy;
+
+  return queue;
+}
+
+int
+queue_free(queue_t *queue)
+{
+  queue_node_t *node;
+
+  assert(queue != NULL);
+
+  // No other thread may use the queue anymore
+  node = queue->head;
+  while (node != NULL)
+  {
+    queue_node_t *next = node->next;
+    queue_node_release(node);
+    node = next;
+  }
+
+  free(queue);
+
+  return 0;
+}
+
+int
+queue_enqueue(queue_t *queue, void *data)
+{
+  queue_node_t *node, *tail, *next;
+  struct backoff backoff;
+
+  assert(queue != NULL);
+
+  node = queue_node_alloc(data);
+  if (node == NULL)
+    return -1;
+
+  queue_enter();
+  for (backoff_init(&backoff);; backoff_retry(&backoff))
+  {
+    tail = queue_protect(0, &queue->tail);
+    next = tail->next;
+    if (tail != queue->tail)
+      continue;
+
+    // Help a late enqueue to swing the tail before linking after it
+    if (next != NULL)
+    {
+      cas((size_t*)&queue->tail, (size_t)tail, (size_t)next);
+      continue;
+    }
+
+    if (cas_release((size_t*)&tail->next, (size_t)NULL, (size_t)node) == (size_t)NULL)
+      break;
+  }
+
+  // Fails harmlessly if another thread helped already
+  cas((size_t*)&queue->tail, (size_t)tail, (size_t)node);
+  queue_leave();
+
+  return 0;
+}
+
+static void
+aba_helper(sem_t* read_sem, sem_t* reinsert_sem)
+{
+  // Signal other thread that we have read the first node
+  sem_post(read_sem);
+
+  // Wait for other thread to dequeue and enqueue again
+  sem_wait(reinsert_sem);
+}
+
+static int
+queue_dequeue_hook(queue_t *queue, void **data,
+                   sem_t* read_sem, sem_t* reinsert_sem)
+{
+  queue_node_t *head, *tail, *next;
+  void *value = NULL;
+  struct backoff backoff;
+  int first_attempt = 1;
+
+  assert(queue != NULL);
+
+  queue_enter();
+  for (backoff_init(&backoff);; backoff_retry(&backoff))
+  {
+    head = queue_protect(0, &queue->head);
+    tail = queue->tail;
+    next = queue_protect(1, &head->next);
+    // next cannot have been freed as long as head is still the head
+    if (head != queue->head)
+      continue;
+
+    if (next == NULL)
+      break;
+
+    // The tail lags behind; help the enqueue that is half done
+    if (head == tail)
+    {
+      cas((size_t*)&queue->tail, (size_t)tail, (size_t)next);
+      continue;
+    }
+
+    // Read the value before the CAS, as another thread may free next as
+    // soon as next becomes the dummy node
+    value = next->data;
+
+    if (read_sem != NULL && first_attempt)
+      aba_helper(read_sem, reinsert_sem);
+    first_attempt = 0;
+
+    if (cas_acquire((size_t*)&queue->head, (size_t)head, (size_t)next) == (size_t)head)
+      break;
+  }
+  queue_leave();
+
+  if (next == NULL)
+    return -1;
+
+  // The former dummy node is not part of the queue anymore
+  queue_node_retire(head);
+
+  if (data != NULL)
+    *data = value;
+
+  return 0;
+}
+
+int
+queue_dequeue(queue_t *queue, void **data)
+{
+  return queue_dequeue_hook(queue, data, NULL, NULL);
+}
+
+int
+queue_dequeue_aba(queue_t *queue, void **data,
+                  sem_t* read_sem, sem_t* reinsert_sem)
+{
+  return queue_dequeue_hook(queue, data, read_sem, reinsert_sem);
+}
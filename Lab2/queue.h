@@ -0,0 +1,49 @@
+/*
+ * queue.h
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ * 
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ * 
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ * 
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+#include <stdlib.h>
+#include <semaphore.h>
+
+#ifndef QUEUE_H
+#define QUEUE_H
+
+// Lock-free FIFO queue (M. Michael and M. Scott, 1996) with any number of
+// producers and consumers. Nodes are managed by the queue: they come from
+// a pool with NODE_POOL and are reclaimed with epochs if RECLAIM=2, with
+// hazard pointers otherwise, as a dequeued node may still be read by
+// other threads.
+
+typedef struct queue queue_t;
+
+queue_t * queue_alloc(void);
+int       queue_free(queue_t *queue);
+
+int       queue_enqueue(queue_t *queue, void *data);
+// Returns -1 if the queue is empty
+int       queue_dequeue(queue_t *queue, void **data);
+
+// Dequeue that waits on reinsert_sem after reading the first node, to
+// reproduce the ABA scenario of the stack test
+int       queue_dequeue_aba(queue_t *queue, void **data,
+                            sem_t* read_sem, sem_t* reinsert_sem);
+
+#endif /* QUEUE_H */
@@ -0,0 +1,419 @@
+/*
+ * queue_test.c
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ * 
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ * 
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ * 
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include <semaphore.h>
+
+#include "queue.h"
+
+#define test_run(test)\
+  printf("[%s:%s:%i] Running test '%s'... ", __FILE__, __FUNCTION__, __LINE__, #test);\
+  test_setup();\
+  if(test())\
+  {\
+    printf("passed\n");\
+  }\
+  else\
+  {\
+    printf("failed\n");\
+  }\
+  test_teardown();
+
+// Elements carry the producer and a sequence number, so that consumers can
+// check the order
+#define ELEMENT(thread, seq) ((void*)(((size_t)(thread) << 32) | ((size_t)(seq) + 1)))
+#define ELEMENT_THREAD(element) ((size_t)(element) >> 32)
+#define ELEMENT_SEQ(element) (((size_t)(element) & 0xffffffff) - 1)
+
+static queue_t *queue;
+
+void
+test_init()
+{
+  // Initialize your test batch
+}
+
+void
+test_setup()
+{
+  // Allocate and initialize your test queue before each test
+  queue = queue_alloc();
+
+#if MEASURE == 2 || MEASURE == 3
+  int i;
+
+  // Fill the queue for dequeue measurements
+  for (i = 0; i < (MEASURE == 2 ? MAX_PUSH_POP : MAX_PUSH_POP / 2); i++)
+    queue_enqueue(queue, ELEMENT(NB_THREADS, i));
+#endif
+}
+
+void
+test_teardown()
+{
+  queue_free(queue);
+}
+
+void
+test_finalize()
+{
+  // Destroy properly your test batch
+}
+
+struct thread_test_args
+{
+  int id;
+  size_t count;
+};
+typedef struct thread_test_args thread_test_args_t;
+
+static int
+run_test_function(void* (*func)(void* arg), thread_test_args_t *args)
+{
+  pthread_attr_t attr;
+  pthread_t thread[NB_THREADS];
+
+  int i;
+  int result = 0;
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      args[i].id = i;
+      args[i].count = 0;
+      pthread_create(&thread[i], &attr, func, &args[i]);
+    }
+
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      void *ret;
+      pthread_join(thread[i], &ret);
+      if (ret != 0)
+        result = -1;
+    }
+
+  return result;
+}
+
+int
+test_fifo()
+{
+  void *element;
+  int i;
+
+  // Elements come out in the order they went in
+  for (i = 0; i < 16; i++)
+    queue_enqueue(queue, ELEMENT(0, i));
+
+  for (i = 0; i < 16; i++)
+    if (queue_dequeue(queue, &element) != 0 || element != ELEMENT(0, i))
+      return 0;
+
+  return queue_dequeue(queue, &element) == -1;
+}
+
+static void*
+thread_test_enqueue(void* arg)
+{
+  thread_test_args_t *args = arg;
+  int i;
+
+  for (i = 0; i < MAX_PUSH_POP; i++)
+    if (queue_enqueue(queue, ELEMENT(args->id, i)) != 0)
+      return (void*)-1;
+
+  return (void*)0;
+}
+
+int
+test_enqueue_safe()
+{
+  thread_test_args_t args[NB_THREADS];
+  size_t next_seq[NB_THREADS] = { 0 }, counter = 0;
+  void *element;
+
+  // Make sure no element is lost and elements of each producer stay in
+  // order when several threads enqueue concurrently
+  if (run_test_function(&thread_test_enqueue, args) != 0)
+    return 0;
+
+  while (queue_dequeue(queue, &element) == 0)
+  {
+    size_t thread = ELEMENT_THREAD(element);
+
+    if (thread >= NB_THREADS || ELEMENT_SEQ(element) != next_seq[thread])
+      return 0;
+    next_seq[thread]++;
+    counter++;
+  }
+
+  return counter == (size_t)(NB_THREADS * MAX_PUSH_POP);
+}
+
+static void*
+thread_test_dequeue(void* arg)
+{
+  thread_test_args_t *args = arg;
+  size_t last_seq = 0;
+  void *element;
+  int i;
+
+  // A single producer filled the queue, so each consumer sees increasing
+  // sequence numbers
+  for (i = 0; i < MAX_PUSH_POP; i++)
+    {
+      if (queue_dequeue(queue, &element) != 0)
+        return (void*)-1;
+      if (i > 0 && ELEMENT_SEQ(element) <= last_seq)
+        return (void*)-1;
+      last_seq = ELEMENT_SEQ(element);
+      args->count++;
+    }
+
+  return (void*)0;
+}
+
+int
+test_dequeue_safe()
+{
+  thread_test_args_t args[NB_THREADS];
+  int i;
+
+  // Same as the test above for parallel dequeue operations
+  for (i = 0; i < NB_THREADS * MAX_PUSH_POP; i++)
+    queue_enqueue(queue, ELEMENT(NB_THREADS, i));
+
+  if (run_test_function(&thread_test_dequeue, args) != 0)
+    return 0;
+
+  return queue_dequeue(queue, NULL) == -1;
+}
+
+static void*
+thread_test_mixed(void* arg)
+{
+  thread_test_args_t *args = arg;
+  void *element;
+  int i;
+
+  // Every thread enqueues and dequeues, so nodes are freed while other
+  // threads may still be reading them
+  for (i = 0; i < MAX_PUSH_POP; i++)
+    {
+      if (queue_enqueue(queue, ELEMENT(args->id, i)) != 0)
+        return (void*)-1;
+      if (queue_dequeue(queue, &element) != 0)
+        return (void*)-1;
+      if (ELEMENT_THREAD(element) >= NB_THREADS)
+        return (void*)-1;
+    }
+
+  return (void*)0;
+}
+
+int
+test_mixed()
+{
+  thread_test_args_t args[NB_THREADS];
+
+  if (run_test_function(&thread_test_mixed, args) != 0)
+    return 0;
+
+  return queue_dequeue(queue, NULL) == -1;
+}
+
+sem_t aba_read_sem, aba_reinsert_sem;
+
+static void*
+aba_thread1(void* arg)
+{
+  void *element;
+
+  // Dequeue the first element, but stall right before the CAS
+  printf("\nThread 1: Dequeuing first element\n");
+  if (queue_dequeue_aba(queue, &element, &aba_read_sem, &aba_reinsert_sem) != 0)
+    return (void*)-1;
+  printf("Thread 1: Finished dequeuing %c\n", (char)(size_t)element);
+
+  return element;
+}
+
+static void*
+aba_thread2(void* arg)
+{
+  void *element;
+
+  printf("Thread 2: Waiting for Thread 1 to be in the middle of dequeuing A\n");
+  sem_wait(&aba_read_sem);
+
+  // Dequeue A and B, so that the node read by thread 1 may be freed, then
+  // enqueue again so that a freed node could be reused
+  if (queue_dequeue(queue, &element) != 0 || element != (void*)'A')
+    goto error;
+  printf("Thread 2: Dequeued A\n");
+  if (queue_dequeue(queue, &element) != 0 || element != (void*)'B')
+    goto error;
+  printf("Thread 2: Dequeued B\n");
+  queue_enqueue(queue, (void*)'D');
+  queue_enqueue(queue, (void*)'E');
+  printf("Thread 2: Enqueued D and E\n");
+
+  sem_post(&aba_reinsert_sem);
+
+  return (void*)0;
+
+error:
+  sem_post(&aba_reinsert_sem);
+  return (void*)-1;
+}
+
+int
+test_aba()
+{
+  pthread_t thread1, thread2;
+  void *ret1, *ret2;
+
+  // Thread 1 must not take A again after thread 2 dequeued A and B; the
+  // safe reclamation must keep the nodes it read from being reused
+  queue_enqueue(queue, (void*)'A');
+  queue_enqueue(queue, (void*)'B');
+  queue_enqueue(queue, (void*)'C');
+
+  sem_init(&aba_read_sem, 0, 0);
+  sem_init(&aba_reinsert_sem, 0, 0);
+
+  pthread_create(&thread1, NULL, aba_thread1, NULL);
+  pthread_create(&thread2, NULL, aba_thread2, NULL);
+
+  pthread_join(thread1, &ret1);
+  pthread_join(thread2, &ret2);
+
+  return ret1 == (void*)'C' && ret2 == (void*)0;
+}
+
+// Queue performance test
+#if MEASURE != 0
+struct queue_measure_arg
+{
+  int id;
+};
+typedef struct queue_measure_arg queue_measure_arg_t;
+
+struct timespec t_start[NB_THREADS], t_stop[NB_THREADS], start, stop;
+
+static void*
+thread_test_performance(void* data)
+{
+  queue_measure_arg_t* arg = (queue_measure_arg_t*)data;
+  void *element;
+  int i;
+
+  for (i = 0; i < MAX_PUSH_POP/NB_THREADS; i++)
+    {
+#if MEASURE == 1
+      if (queue_enqueue(queue, ELEMENT(arg->id, i)) != 0)
+        return (void*)-1;
+#elif MEASURE == 2
+      if (queue_dequeue(queue, &element) != 0)
+        return (void*)-1;
+#else
+      // Alternate enqueue and dequeue
+      if (i % 2 == 0 ? queue_enqueue(queue, ELEMENT(arg->id, i)) != 0 :
+          queue_dequeue(queue, &element) != 0)
+        return (void*)-1;
+#endif
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &t_stop[arg->id]);
+  return (void*)0;
+}
+#endif
+
+int
+main(int argc, char **argv)
+{
+setbuf(stdout, NULL);
+// MEASURE == 0 -> run unit tests
+#if MEASURE == 0
+  test_init();
+
+  test_run(test_fifo);
+  test_run(test_enqueue_safe);
+  test_run(test_dequeue_safe);
+  test_run(test_mixed);
+  test_run(test_aba);
+
+  test_finalize();
+#else
+  // Run performance tests
+  int i;
+  queue_measure_arg_t arg[NB_THREADS];
+  pthread_attr_t attr;
+  pthread_t thread[NB_THREADS];
+
+  test_setup();
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      arg[i].id = i;
+      clock_gettime(CLOCK_MONOTONIC, &t_start[i]);
+      pthread_create(&thread[i], &attr, &thread_test_performance, &arg[i]);
+    }
+
+  // Wait for all threads to finish
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      pthread_join(thread[i], NULL);
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+
+  // Print out results
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      printf("%i %i %li %i %li %i %li %i %li\n", i, (int) start.tv_sec,
+          start.tv_nsec, (int) stop.tv_sec, stop.tv_nsec,
+          (int) t_start[i].tv_sec, t_start[i].tv_nsec, (int) t_stop[i].tv_sec,
+          t_stop[i].tv_nsec);
+    }
+#endif
+
+  return 0;
+}
@@ -0,0 +1,119 @@
+/*
+ * registry.c
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ *
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "registry.h"
+#include "non_blocking.h"
+
+#define REGISTRY_MAX_HOOKS 8
+
+static size_t taken[REGISTRY_MAX_THREADS];
+static volatile size_t high_water;
+
+static void (*hooks[REGISTRY_MAX_HOOKS])(int);
+static size_t nb_hooks;
+
+static pthread_key_t key;
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static __thread int thread_id = -1;
+
+static void
+registry_release(void *value)
+{
+  int id = (int)(intptr_t)value - 1;
+  size_t i;
+
+  // Hooks may use the identifier, so give it back only afterwards
+  thread_id = id;
+  for (i = 0; i < nb_hooks && i < REGISTRY_MAX_HOOKS; i++)
+    if (hooks[i] != NULL)
+      hooks[i](id);
+  thread_id = -1;
+
+  __sync_synchronize();
+  taken[id] = 0;
+}
+
+static void
+registry_init(void)
+{
+  pthread_key_create(&key, registry_release);
+}
+
+int
+registry_thread_id(void)
+{
+  int id;
+  size_t high;
+
+  if (thread_id >= 0)
+    return thread_id;
+
+  pthread_once(&key_once, registry_init);
+
+  for (id = 0; id < REGISTRY_MAX_THREADS; id++)
+    if (taken[id] == 0 && cas(&taken[id], 0, 1) == 0)
+      break;
+
+  if (id == REGISTRY_MAX_THREADS)
+  {
+    fprintf(stderr, "[ERROR] More than %i threads in registry\n",
+        REGISTRY_MAX_THREADS);
+    abort();
+  }
+
+  do {
+    high = high_water;
+  } while (high <= (size_t)id && cas((size_t*)&high_water, high, id + 1) != high);
+
+  thread_id = id;
+  pthread_setspecific(key, (void*)(intptr_t)(id + 1));
+
+  return id;
+}
+
+int
+registry_threads(void)
+{
+  return (int)high_water;
+}
+
+int
+registry_on_exit(void (*hook)(int id))
+{
+  size_t slot = __sync_fetch_and_add(&nb_hooks, 1);
+
+  if (slot >= REGISTRY_MAX_HOOKS)
+    return -1;
+
+  hooks[slot] = hook;
+  return 0;
+}
@@ -0,0 +1,43 @@
+/*
+ * registry.h
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ *
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef REGISTRY_H_
+#define REGISTRY_H_
+
+// Maximal number of threads alive at the same time that use the registry
+#ifndef REGISTRY_MAX_THREADS
+#define REGISTRY_MAX_THREADS 128
+#endif
+
+// Dense identifier of the calling thread, in [0, REGISTRY_MAX_THREADS).
+// Identifiers are given back when their thread exits and reused by threads
+// created later, so that per-thread arrays stay small.
+int registry_thread_id(void);
+
+// Upper bound of all identifiers handed out so far
+int registry_threads(void);
+
+// Register a function called with the identifier of each exiting thread,
+// before its identifier is reused. Returns -1 if there are too many hooks.
+int registry_on_exit(void (*hook)(int id));
+
+#endif /* REGISTRY_H_ */
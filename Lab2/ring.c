@@ -0,0 +1,190 @@
+/*
+ * ring.c
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ * 
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ * 
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ * 
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ring.h"
+#include "non_blocking.h"
+#include "backoff.h"
+
+#define CACHE_LINE_SIZE 64
+
+// Slot i can be written in lap l when its sequence number is l * capacity
+// + i, and read once the producer has set it to that plus one
+struct ring_slot
+{
+  size_t seq;
+  void *data;
+};
+
+struct ring
+{
+  // Written by producers and consumers respectively; the slots stay packed
+  // so that batches touch as few cache lines as possible
+  size_t tail __attribute__((aligned(CACHE_LINE_SIZE)));
+  size_t head __attribute__((aligned(CACHE_LINE_SIZE)));
+  size_t mask __attribute__((aligned(CACHE_LINE_SIZE)));
+  struct ring_slot *slots;
+};
+
+ring_t *
+ring_alloc(size_t capacity)
+{
+  ring_t *ring;
+  size_t size, i;
+
+  for (size = 1; size < capacity; size *= 2)
+    ;
+
+  if (posix_memalign((void**)&ring, CACHE_LINE_SIZE, sizeof(struct ring)) != 0)
+    return NULL;
+  if (posix_memalign((void**)&ring->slots, CACHE_LINE_SIZE, size * sizeof(struct ring_slot)) != 0)
+  {
+    free(ring);
+    return NULL;
+  }
+
+  for (i = 0; i < size; i++)
+    ring->slots[i].seq = i;
+  ring->mask = size - 1;
+  ring->head = 0;
+  ring->tail = 0;
+
+  return ring;
+}
+
+int
+ring_free(ring_t *ring)
+{
+  assert(ring != NULL);
+
+  free(ring->slots);
+  free(ring);
+
+  return 0;
+}
+
+size_t
+ring_capacity(ring_t *ring)
+{
+  return ring->mask + 1;
+}
+
+// Claim up to n consecutive slots from *end, whose sequence numbers must be
+// their position plus offset. Returns how many were claimed, from *pos.
+static size_t
+ring_claim(ring_t *ring, size_t *end, size_t offset, size_t n, size_t *pos)
+{
+  struct backoff backoff;
+  size_t count, seq;
+
+  if (n == 0)
+    return 0;
+
+  for (backoff_init(&backoff);; backoff_retry(&backoff))
+  {
+    *pos = *(volatile size_t*)end;
+    for (count = 0; count < n; count++)
+    {
+      seq = load_acquire(&ring->slots[(*pos + count) & ring->mask].seq);
+      if (seq != *pos + count + offset)
+        break;
+    }
+
+    if (count == 0)
+    {
+      // Full or empty if the first slot lags a lap behind; otherwise
+      // another thread claimed it meanwhile
+      if ((intptr_t)(seq - (*pos + offset)) < 0)
+        return 0;
+      continue;
+    }
+
+    if (cas(end, *pos, *pos + count) == *pos)
+      return count;
+  }
+}
+
+size_t
+ring_enqueue_n(ring_t *ring, void * const *data, size_t n)
+{
+  size_t pos, count, i;
+
+  assert(ring != NULL);
+
+  count = ring_claim(ring, &ring->tail, 0, n, &pos);
+  for (i = 0; i < count; i++)
+  {
+    struct ring_slot *slot = &ring->slots[(pos + i) & ring->mask];
+    slot->data = data[i];
+    store_release(&slot->seq, pos + i + 1);
+  }
+
+  return count;
+}
+
+size_t
+ring_dequeue_n(ring_t *ring, void **data, size_t n)
+{
+  size_t pos, count, i;
+
+  assert(ring != NULL);
+
+  count = ring_claim(ring, &ring->head, 1, n, &pos);
+  for (i = 0; i < count; i++)
+  {
+    struct ring_slot *slot = &ring->slots[(pos + i) & ring->mask];
+    data[i] = slot->data;
+    // Free for the next lap
+    store_release(&slot->seq, pos + i + ring->mask + 1);
+  }
+
+  return count;
+}
+
+int
+ring_enqueue(ring_t *ring, void *data)
+{
+  return ring_enqueue_n(ring, &data, 1) == 1 ? 0 : -1;
+}
+
+int
+ring_dequeue(ring_t *ring, void **data)
+{
+  void *element;
+
+  if (ring_dequeue_n(ring, &element, 1) != 1)
+    return -1;
+
+  if (data != NULL)
+    *data = element;
+
+  return 0;
+}
@@ -0,0 +1,52 @@
+/*
+ * ring.h
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ * 
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ * 
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ * 
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+
+#include <stddef.h>
+
+#ifndef RING_H_
+#define RING_H_
+
+// Bounded queue in a ring buffer for any number of producers and consumers
+// (D. Vyukov). Every slot has a sequence number telling in which lap it can
+// be written or read, so that producers and consumers only synchronize on
+// the head or tail and on the slots they claimed. Nothing is allocated
+// after ring_alloc().
+
+typedef struct ring ring_t;
+
+// The capacity is rounded up to a power of two
+ring_t * ring_alloc(size_t capacity);
+int      ring_free(ring_t *ring);
+
+size_t   ring_capacity(ring_t *ring);
+
+// Return -1 if the ring is full or empty
+int      ring_enqueue(ring_t *ring, void *data);
+int      ring_dequeue(ring_t *ring, void **data);
+
+// Transfer up to n elements in order with a single claim of consecutive
+// slots; return how many were transferred
+size_t   ring_enqueue_n(ring_t *ring, void * const *data, size_t n);
+size_t   ring_dequeue_n(ring_t *ring, void **data, size_t n);
+
+#endif /* RING_H_ */
@@ -0,0 +1,466 @@
+/*
+ * ring_test.c
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ * 
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ * 
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ * 
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include <sched.h>
+
+#include "ring.h"
+
+#define test_run(test)\
+  printf("[%s:%s:%i] Running test '%s'... ", __FILE__, __FUNCTION__, __LINE__, #test);\
+  test_setup();\
+  if(test())\
+  {\
+    printf("passed\n");\
+  }\
+  else\
+  {\
+    printf("failed\n");\
+  }\
+  test_teardown();
+
+// Elements carry the producer and a sequence number, so that consumers can
+// check the order
+#define ELEMENT(thread, seq) ((void*)(((size_t)(thread) << 32) | ((size_t)(seq) + 1)))
+#define ELEMENT_THREAD(element) ((size_t)(element) >> 32)
+#define ELEMENT_SEQ(element) (((size_t)(element) & 0xffffffff) - 1)
+
+// Transfer size of the batched operations in the tests
+#define RING_BATCH 8
+
+static ring_t *ring;
+
+void
+test_init()
+{
+  // Initialize your test batch
+}
+
+void
+test_setup()
+{
+  // Allocate and initialize your test ring before each test; it is large
+  // enough for every element of the tests and benchmarks
+  ring = ring_alloc(NB_THREADS * MAX_PUSH_POP);
+
+#if MEASURE == 2 || MEASURE == 3
+  int i;
+
+  // Fill the ring for dequeue measurements
+  for (i = 0; i < (MEASURE == 2 ? MAX_PUSH_POP : MAX_PUSH_POP / 2); i++)
+    ring_enqueue(ring, ELEMENT(NB_THREADS, i));
+#endif
+}
+
+void
+test_teardown()
+{
+  ring_free(ring);
+}
+
+void
+test_finalize()
+{
+  // Destroy properly your test batch
+}
+
+struct thread_test_args
+{
+  int id;
+  size_t count;
+};
+typedef struct thread_test_args thread_test_args_t;
+
+static int
+run_test_function(void* (*func)(void* arg), thread_test_args_t *args)
+{
+  pthread_attr_t attr;
+  pthread_t thread[NB_THREADS];
+
+  int i;
+  int result = 0;
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      args[i].id = i;
+      args[i].count = 0;
+      pthread_create(&thread[i], &attr, func, &args[i]);
+    }
+
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      void *ret;
+      pthread_join(thread[i], &ret);
+      if (ret != 0)
+        result = -1;
+    }
+
+  return result;
+}
+
+int
+test_fifo()
+{
+  void *element;
+  int i;
+
+  // Elements come out in the order they went in
+  for (i = 0; i < 16; i++)
+    ring_enqueue(ring, ELEMENT(0, i));
+
+  for (i = 0; i < 16; i++)
+    if (ring_dequeue(ring, &element) != 0 || element != ELEMENT(0, i))
+      return 0;
+
+  return ring_dequeue(ring, &element) == -1;
+}
+
+int
+test_full()
+{
+  size_t capacity = ring_capacity(ring), i, lap;
+  void *element;
+
+  if (capacity < (size_t)(NB_THREADS * MAX_PUSH_POP) || (capacity & (capacity - 1)) != 0)
+    return 0;
+
+  // Fill and empty the ring a few times, so that slots are reused in
+  // later laps, and check it refuses elements only when full
+  for (lap = 0; lap < 3; lap++)
+    {
+      for (i = 0; i < capacity; i++)
+        if (ring_enqueue(ring, ELEMENT(0, i)) != 0)
+          return 0;
+      if (ring_enqueue(ring, ELEMENT(0, i)) != -1)
+        return 0;
+
+      for (i = 0; i < capacity; i++)
+        if (ring_dequeue(ring, &element) != 0 || element != ELEMENT(0, i))
+          return 0;
+      if (ring_dequeue(ring, &element) != -1)
+        return 0;
+    }
+
+  return 1;
+}
+
+int
+test_batch()
+{
+  void *in[RING_BATCH], *out[2 * RING_BATCH];
+  size_t capacity = ring_capacity(ring), i, done;
+
+  for (i = 0; i < RING_BATCH; i++)
+    in[i] = ELEMENT(0, i);
+
+  // Leave less room than a batch, which must be transferred partially
+  for (i = 0; i < capacity - RING_BATCH / 2; i++)
+    ring_enqueue(ring, ELEMENT(1, i));
+  if (ring_enqueue_n(ring, in, RING_BATCH) != RING_BATCH / 2)
+    return 0;
+  if (ring_enqueue_n(ring, in, RING_BATCH) != 0)
+    return 0;
+
+  for (i = 0; i < capacity - RING_BATCH / 2; i += done)
+    {
+      done = capacity - RING_BATCH / 2 - i;
+      done = ring_dequeue_n(ring, out, done < 2 * RING_BATCH ? done : 2 * RING_BATCH);
+      if (done == 0 || out[0] != ELEMENT(1, i))
+        return 0;
+    }
+
+  // The batch ends the ring in order, after the elements enqueued before
+  return i == capacity - RING_BATCH / 2
+      && ring_dequeue_n(ring, out, 2 * RING_BATCH) == RING_BATCH / 2
+      && out[0] == ELEMENT(0, 0) && out[RING_BATCH / 2 - 1] == ELEMENT(0, RING_BATCH / 2 - 1)
+      && ring_dequeue_n(ring, out, 2 * RING_BATCH) == 0;
+}
+
+static void*
+thread_test_enqueue(void* arg)
+{
+  thread_test_args_t *args = arg;
+  void *batch[RING_BATCH];
+  int i, j;
+
+  // Alternate single and batched operations
+  for (i = 0; i < MAX_PUSH_POP; i += j)
+    {
+      if (i % (2 * RING_BATCH) == 0)
+        {
+          if (ring_enqueue(ring, ELEMENT(args->id, i)) != 0)
+            return (void*)-1;
+          j = 1;
+          continue;
+        }
+
+      for (j = 0; j < RING_BATCH && i + j < MAX_PUSH_POP; j++)
+        batch[j] = ELEMENT(args->id, i + j);
+      if (ring_enqueue_n(ring, batch, j) != j)
+        return (void*)-1;
+    }
+
+  return (void*)0;
+}
+
+int
+test_enqueue_safe()
+{
+  thread_test_args_t args[NB_THREADS];
+  size_t next_seq[NB_THREADS] = { 0 }, counter = 0;
+  void *element;
+
+  // Make sure no element is lost and elements of each producer stay in
+  // order when several threads enqueue concurrently
+  if (run_test_function(&thread_test_enqueue, args) != 0)
+    return 0;
+
+  while (ring_dequeue(ring, &element) == 0)
+  {
+    size_t thread = ELEMENT_THREAD(element);
+
+    if (thread >= NB_THREADS || ELEMENT_SEQ(element) != next_seq[thread])
+      return 0;
+    next_seq[thread]++;
+    counter++;
+  }
+
+  return counter == (size_t)(NB_THREADS * MAX_PUSH_POP);
+}
+
+static void*
+thread_test_dequeue(void* arg)
+{
+  thread_test_args_t *args = arg;
+  size_t last_seq = 0, done, j;
+  void *batch[RING_BATCH];
+
+  // A single producer filled the ring, so each consumer sees increasing
+  // sequence numbers, also within its batches
+  while (args->count < MAX_PUSH_POP)
+    {
+      done = ring_dequeue_n(ring, batch, MAX_PUSH_POP - args->count < RING_BATCH ?
+          MAX_PUSH_POP - args->count : RING_BATCH);
+      if (done == 0)
+        return (void*)-1;
+      for (j = 0; j < done; j++)
+        {
+          if (args->count > 0 && ELEMENT_SEQ(batch[j]) <= last_seq)
+            return (void*)-1;
+          last_seq = ELEMENT_SEQ(batch[j]);
+          args->count++;
+        }
+    }
+
+  return (void*)0;
+}
+
+int
+test_dequeue_safe()
+{
+  thread_test_args_t args[NB_THREADS];
+  int i;
+
+  // Same as the test above for parallel dequeue operations
+  for (i = 0; i < NB_THREADS * MAX_PUSH_POP; i++)
+    ring_enqueue(ring, ELEMENT(NB_THREADS, i));
+
+  if (run_test_function(&thread_test_dequeue, args) != 0)
+    return 0;
+
+  return ring_dequeue(ring, NULL) == -1;
+}
+
+static int seen[NB_THREADS][MAX_PUSH_POP];
+
+static void*
+thread_test_pipeline(void* arg)
+{
+  thread_test_args_t *args = arg;
+  void *batch[RING_BATCH];
+  size_t i, j, pending;
+
+  // Every thread hands batches over to whichever thread dequeues them. The
+  // ring only holds a batch per thread, so it wraps around constantly and
+  // operations fail while other threads have claimed but not yet filled
+  // or read their slots.
+  for (i = 0; i < MAX_PUSH_POP; i += RING_BATCH)
+    {
+      for (j = 0; j < RING_BATCH && i + j < MAX_PUSH_POP; j++)
+        batch[j] = ELEMENT(args->id, i + j);
+      for (pending = j; pending > 0;)
+        {
+          size_t done = ring_enqueue_n(ring, batch + j - pending, pending);
+          if (done == 0)
+            sched_yield();
+          pending -= done;
+        }
+
+      for (pending = j; pending > 0;)
+        {
+          size_t done = ring_dequeue_n(ring, batch, pending);
+          if (done == 0)
+            sched_yield();
+          for (j = 0; j < done; j++)
+            {
+              if (ELEMENT_THREAD(batch[j]) >= NB_THREADS || ELEMENT_SEQ(batch[j]) >= MAX_PUSH_POP)
+                return (void*)-1;
+              __sync_fetch_and_add(&seen[ELEMENT_THREAD(batch[j])][ELEMENT_SEQ(batch[j])], 1);
+            }
+          pending -= done;
+        }
+    }
+
+  return (void*)0;
+}
+
+int
+test_pipeline()
+{
+  thread_test_args_t args[NB_THREADS];
+  int i, j;
+
+  ring_free(ring);
+  ring = ring_alloc(NB_THREADS * RING_BATCH);
+  memset(seen, 0, sizeof(seen));
+
+  if (run_test_function(&thread_test_pipeline, args) != 0)
+    return 0;
+
+  // Every element went through exactly once
+  for (i = 0; i < NB_THREADS; i++)
+    for (j = 0; j < MAX_PUSH_POP; j++)
+      if (seen[i][j] != 1)
+        return 0;
+
+  return ring_dequeue(ring, NULL) == -1;
+}
+
+// Ring performance test
+#if MEASURE != 0
+struct ring_measure_arg
+{
+  int id;
+};
+typedef struct ring_measure_arg ring_measure_arg_t;
+
+struct timespec t_start[NB_THREADS], t_stop[NB_THREADS], start, stop;
+
+static void*
+thread_test_performance(void* data)
+{
+  ring_measure_arg_t* arg = (ring_measure_arg_t*)data;
+  void *element;
+  int i;
+
+  for (i = 0; i < MAX_PUSH_POP/NB_THREADS; i++)
+    {
+#if MEASURE == 1
+      if (ring_enqueue(ring, ELEMENT(arg->id, i)) != 0)
+        return (void*)-1;
+#elif MEASURE == 2
+      if (ring_dequeue(ring, &element) != 0)
+        return (void*)-1;
+#else
+      // Alternate enqueue and dequeue
+      if (i % 2 == 0 ? ring_enqueue(ring, ELEMENT(arg->id, i)) != 0 :
+          ring_dequeue(ring, &element) != 0)
+        return (void*)-1;
+#endif
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &t_stop[arg->id]);
+  return (void*)0;
+}
+#endif
+
+int
+main(int argc, char **argv)
+{
+setbuf(stdout, NULL);
+// MEASURE == 0 -> run unit tests
+#if MEASURE == 0
+  test_init();
+
+  test_run(test_fifo);
+  test_run(test_full);
+  test_run(test_batch);
+  test_run(test_enqueue_safe);
+  test_run(test_dequeue_safe);
+  test_run(test_pipeline);
+
+  test_finalize();
+#else
+  // Run performance tests
+  int i;
+  ring_measure_arg_t arg[NB_THREADS];
+  pthread_attr_t attr;
+  pthread_t thread[NB_THREADS];
+
+  test_setup();
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      arg[i].id = i;
+      clock_gettime(CLOCK_MONOTONIC, &t_start[i]);
+      pthread_create(&thread[i], &attr, &thread_test_performance, &arg[i]);
+    }
+
+  // Wait for all threads to finish
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      pthread_join(thread[i], NULL);
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+
+  // Print out results
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      printf("%i %i %li %i %li %i %li %i %li\n", i, (int) start.tv_sec,
+          start.tv_nsec, (int) stop.tv_sec, stop.tv_nsec,
+          (int) t_start[i].tv_sec, t_start[i].tv_nsec, (int) t_stop[i].tv_sec,
+          t_stop[i].tv_nsec);
+    }
+#endif
+
+  return 0;
+}
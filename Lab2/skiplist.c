@@ -0,0 +1,382 @@
+/*
+ * skiplist.c
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ * 
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ * 
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ * 
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "skiplist.h"
+#include "non_blocking.h"
+#include "backoff.h"
+#include "epoch.h"
+
+// Levels of the head; with one node in two promoted to the next level, it
+// stays balanced up to 2^SKIPLIST_MAX_LEVEL keys
+#define SKIPLIST_MAX_LEVEL 24
+
+// Low bit of a next pointer, set when its node is being removed
+#define MARK ((size_t)1)
+#define IS_MARKED(next) (((next) & MARK) != 0)
+#define NODE(next) ((skiplist_node_t*)((next) & ~MARK))
+
+struct skiplist_node
+{
+  size_t key;
+  void *value;
+  int level;
+  // The inserter and the remover; whichever is done last retires the node,
+  // as the inserter may still be linking upper levels of a removed node
+  int owners;
+  // Epoch the node was allocated in, see epoch.h
+  size_t birth;
+  size_t next[];
+};
+typedef struct skiplist_node skiplist_node_t;
+
+struct skiplist
+{
+  skiplist_node_t *head;
+  // Highest level of any node inserted so far; traversals start there
+  // instead of walking the empty levels of the head
+  size_t levels;
+};
+
+static __thread unsigned int level_seed;
+
+// Level of a new node, from 1 to SKIPLIST_MAX_LEVEL with probability
+// halving at each level
+static int
+skiplist_random_level(void)
+{
+  unsigned int x = level_seed;
+
+  if (x == 0)
+    x = 2654435761u * (unsigned int)(size_t)&level_seed | 1;
+
+  // xorshift
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  level_seed = x;
+
+  return 1 + __builtin_ctz(x | 1u << (SKIPLIST_MAX_LEVEL - 1));
+}
+
+static void
+skiplist_node_put(skiplist_node_t *node)
+{
+  if (__sync_sub_and_fetch(&node->owners, 1) == 0)
+    epoch_retire(node, node->birth, free);
+}
+
+// Fill preds and succs with the nodes around key at every level, unlinking
+// the marked nodes met on the way. Returns the node holding key, if any.
+static skiplist_node_t *
+skiplist_search(skiplist_t *list, size_t key, skiplist_node_t **preds,
+    skiplist_node_t **succs)
+{
+  skiplist_node_t *pred, *curr;
+  struct backoff backoff;
+  size_t next;
+  int level, top;
+
+  backoff_init(&backoff);
+
+retry:
+  pred = list->head;
+  top = (int)load_acquire(&list->levels);
+  for (level = SKIPLIST_MAX_LEVEL - 1; level >= top; level--)
+  {
+    preds[level] = pred;
+    succs[level] = NULL;
+  }
+  for (; level >= 0; level--)
+  {
+    curr = NODE(epoch_read(&pred->next[level]));
+    while (curr != NULL)
+    {
+      next = epoch_read(&curr->next[level]);
+      if (IS_MARKED(next))
+      {
+        // Fails if pred changed or is being removed itself
+        if (cas(&pred->next[level], (size_t)curr, next & ~MARK) != (size_t)curr)
+        {
+          backoff_retry(&backoff);
+          goto retry;
+        }
+        curr = NODE(next);
+        continue;
+      }
+      if (curr->key >= key)
+        break;
+      pred = curr;
+      curr = NODE(next);
+    }
+    preds[level] = pred;
+    succs[level] = curr;
+  }
+
+  return succs[0] != NULL && succs[0]->key == key ? succs[0] : NULL;
+}
+
+// First node with a key not below key at the bottom level, without
+// unlinking anything, so that readers never write to the list
+static skiplist_node_t *
+skiplist_lookup(skiplist_t *list, size_t key)
+{
+  skiplist_node_t *pred = list->head, *curr = NULL;
+  size_t next;
+  int level;
+
+  for (level = (int)load_acquire(&list->levels) - 1; level >= 0; level--)
+  {
+    curr = NODE(epoch_read(&pred->next[level]));
+    while (curr != NULL)
+    {
+      next = epoch_read(&curr->next[level]);
+      if (IS_MARKED(next))
+        curr = NODE(next);
+      else if (curr->key < key)
+      {
+        pred = curr;
+        curr = NODE(next);
+      }
+      else
+        break;
+    }
+  }
+
+  return curr;
+}
+
+skiplist_t *
+skiplist_alloc(void)
+{
+  skiplist_t *list = malloc(sizeof(skiplist_t));
+
+  if (list == NULL)
+    return NULL;
+
+  list->head = calloc(1, sizeof(skiplist_node_t) + SKIPLIST_MAX_LEVEL * sizeof(size_t));
+  if (list->head == NULL)
+  {
+    free(list);
+    return NULL;
+  }
+  list->head->level = SKIPLIST_MAX_LEVEL;
+  list->levels = 1;
+
+  return list;
+}
+
+int
+skiplist_free(skiplist_t *list)
+{
+  skiplist_node_t *node, *next;
+
+  // Removed nodes are unlinked before their remove returns, and are
+  // released by the epochs
+  for (node = NODE(list->head->next[0]); node != NULL; node = next)
+  {
+    next = NODE(node->next[0]);
+    free(node);
+  }
+  free(list->head);
+  free(list);
+
+  return 0;
+}
+
+int
+skiplist_insert(skiplist_t *list, size_t key, void *value)
+{
+  skiplist_node_t *preds[SKIPLIST_MAX_LEVEL], *succs[SKIPLIST_MAX_LEVEL], *node;
+  int level = skiplist_random_level(), i;
+  struct backoff backoff;
+  size_t next, levels;
+
+  node = malloc(sizeof(skiplist_node_t) + level * sizeof(size_t));
+  if (node == NULL)
+    return -1;
+  node->key = key;
+  node->value = value;
+  node->level = level;
+  node->owners = 2;
+  node->birth = epoch_birth();
+
+  // Raise the levels searched before searching, so that the node is not
+  // linked at a level other searches skip
+  do {
+    levels = load_acquire(&list->levels);
+  } while (levels < (size_t)level && cas(&list->levels, levels, level) != levels);
+
+  backoff_init(&backoff);
+  epoch_enter();
+
+  // Linking the bottom level inserts the key
+  do {
+    if (skiplist_search(list, key, preds, succs) != NULL)
+    {
+      epoch_exit();
+      free(node);
+      return -1;
+    }
+    for (i = 0; i < level; i++)
+      node->next[i] = (size_t)succs[i];
+  } while (cas_release(&preds[0]->next[0], (size_t)succs[0], (size_t)node) != (size_t)succs[0]
+      && backoff_retry(&backoff));
+
+  // Then the upper levels, bottom up, unless the node is removed meanwhile
+  for (i = 1; i < level; i++)
+  {
+    for (;;)
+    {
+      next = load_acquire(&node->next[i]);
+      if (IS_MARKED(next))
+        goto done;
+      if (next != (size_t)succs[i] && cas(&node->next[i], next, (size_t)succs[i]) != next)
+        continue;
+      if (cas_release(&preds[i]->next[i], (size_t)succs[i], (size_t)node) == (size_t)succs[i])
+        break;
+
+      backoff_retry(&backoff);
+      if (skiplist_search(list, key, preds, succs) != node)
+        goto done;
+    }
+
+    // The remover unlinks the node once marked at the bottom level. If it
+    // already did, this level was linked too late and must be unlinked
+    // again; the fence orders the check after the link.
+    __sync_synchronize();
+    if (IS_MARKED(node->next[0]))
+    {
+      skiplist_search(list, key, preds, succs);
+      goto done;
+    }
+  }
+
+done:
+  epoch_exit();
+  skiplist_node_put(node);
+
+  return 0;
+}
+
+int
+skiplist_remove(skiplist_t *list, size_t key, void **value)
+{
+  skiplist_node_t *preds[SKIPLIST_MAX_LEVEL], *succs[SKIPLIST_MAX_LEVEL], *node;
+  size_t next;
+  int i;
+
+  epoch_enter();
+
+  node = skiplist_search(list, key, preds, succs);
+  if (node == NULL)
+  {
+    epoch_exit();
+    return -1;
+  }
+
+  // Mark the upper levels first, so that no level can be linked anymore
+  // once the node is marked at the bottom
+  for (i = node->level - 1; i > 0; i--)
+  {
+    do {
+      next = load_acquire(&node->next[i]);
+    } while (!IS_MARKED(next) && cas(&node->next[i], next, next | MARK) != next);
+  }
+
+  // Marking the bottom level removes the key; only one remover succeeds
+  do {
+    next = load_acquire(&node->next[0]);
+    if (IS_MARKED(next))
+    {
+      epoch_exit();
+      return -1;
+    }
+  } while (cas(&node->next[0], next, next | MARK) != next);
+
+  if (value != NULL)
+    *value = node->value;
+
+  // Unlink the node from every level; pairs with the fence in insert
+  __sync_synchronize();
+  skiplist_search(list, key, preds, succs);
+
+  epoch_exit();
+  skiplist_node_put(node);
+
+  return 0;
+}
+
+int
+skiplist_find(skiplist_t *list, size_t key, void **value)
+{
+  skiplist_node_t *node;
+  int found;
+
+  epoch_enter();
+
+  node = skiplist_lookup(list, key);
+  found = node != NULL && node->key == key;
+  if (found && value != NULL)
+    *value = node->value;
+
+  epoch_exit();
+
+  return found ? 0 : -1;
+}
+
+size_t
+skiplist_range(skiplist_t *list, size_t from, size_t to, size_t *keys,
+    void **values, size_t n)
+{
+  skiplist_node_t *node;
+  size_t count = 0, next;
+
+  if (from > to)
+    return 0;
+
+  epoch_enter();
+
+  for (node = skiplist_lookup(list, from); node != NULL && node->key <= to
+      && count < n; node = NODE(next))
+  {
+    next = epoch_read(&node->next[0]);
+    if (IS_MARKED(next))
+      continue;
+    keys[count] = node->key;
+    if (values != NULL)
+      values[count] = node->value;
+    count++;
+  }
+
+  epoch_exit();
+
+  return count;
+}
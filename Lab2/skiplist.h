@@ -0,0 +1,53 @@
+/*
+ * skiplist.h
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ * 
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ * 
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ * 
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+#include <stddef.h>
+
+#ifndef SKIPLIST_H_
+#define SKIPLIST_H_
+
+// Lock-free ordered map of size_t keys (Fraser 2004, Herlihy & Shavit). A
+// node is removed by marking its next pointers, upper levels first; any
+// operation running into a marked node unlinks it on its way. Lookups and
+// range scans only read the list. Removed nodes are reclaimed through
+// epochs (epoch.h), so they may be called from any number of threads.
+
+typedef struct skiplist skiplist_t;
+
+skiplist_t * skiplist_alloc(void);
+// Not thread-safe: no other operation may run on the list
+int          skiplist_free(skiplist_t *list);
+
+// Return -1 if the key is already present
+int          skiplist_insert(skiplist_t *list, size_t key, void *value);
+// Return -1 if the key is absent; value may be NULL
+int          skiplist_remove(skiplist_t *list, size_t key, void **value);
+int          skiplist_find(skiplist_t *list, size_t key, void **value);
+
+// Copy up to n entries with keys in [from, to] in increasing key order, and
+// return how many were copied. The scan is not a snapshot: entries inserted
+// or removed meanwhile may or may not be seen, but every entry copied was
+// present at some point during the scan.
+size_t       skiplist_range(skiplist_t *list, size_t from, size_t to,
+    size_t *keys, void **values, size_t n);
+
+#endif /* SKIPLIST_H_ */
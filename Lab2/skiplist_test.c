@@ -0,0 +1,391 @@
+/*
+ * skiplist_test.c
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ * 
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ * 
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ * 
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+
+#ifndef DEBUG
+#define NDEBUG
+#endif
+
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "skiplist.h"
+
+#define test_run(test)\
+  printf("[%s:%s:%i] Running test '%s'... ", __FILE__, __FUNCTION__, __LINE__, #test);\
+  test_setup();\
+  if(test())\
+  {\
+    printf("passed\n");\
+  }\
+  else\
+  {\
+    printf("failed\n");\
+  }\
+  test_teardown();
+
+// Values are derived from their key, so that lookups can check them
+#define VALUE(key) ((void*)((size_t)(key) * 2 + 1))
+
+// Keys of the tests
+#define NB_KEYS (NB_THREADS * MAX_PUSH_POP)
+
+static skiplist_t *list;
+
+void
+test_init()
+{
+  // Initialize your test batch
+}
+
+void
+test_setup()
+{
+  // Allocate and initialize your test list before each test
+  list = skiplist_alloc();
+
+#if MEASURE == 2 || MEASURE == 3
+  int i;
+
+  // Fill the list for remove and lookup measurements; the threads of the
+  // latter insert and remove keys above these
+  for (i = 0; i < MAX_PUSH_POP; i++)
+    skiplist_insert(list, i, VALUE(i));
+#endif
+}
+
+void
+test_teardown()
+{
+  skiplist_free(list);
+}
+
+void
+test_finalize()
+{
+  // Destroy properly your test batch
+}
+
+struct thread_test_args
+{
+  int id;
+  size_t count;
+};
+typedef struct thread_test_args thread_test_args_t;
+
+static int
+run_test_function(void* (*func)(void* arg), thread_test_args_t *args)
+{
+  pthread_attr_t attr;
+  pthread_t thread[NB_THREADS];
+
+  int i;
+  int result = 0;
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      args[i].id = i;
+      args[i].count = 0;
+      pthread_create(&thread[i], &attr, func, &args[i]);
+    }
+
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      void *ret;
+      pthread_join(thread[i], &ret);
+      if (ret != 0)
+        result = -1;
+    }
+
+  return result;
+}
+
+// Check that the list holds exactly the keys from, from + step, ... below to
+static int
+check_keys(size_t from, size_t to, size_t step)
+{
+  size_t keys[64], key = from, done, i;
+  void *values[64];
+
+  do {
+    done = skiplist_range(list, key, to, keys, values, 64);
+    for (i = 0; i < done; i++, key += step)
+      if (keys[i] != key || values[i] != VALUE(key))
+        return 0;
+  } while (done == 64);
+
+  return key >= to;
+}
+
+int
+test_order()
+{
+  void *value;
+  size_t i, key;
+
+  // Keys come out sorted whatever the insertion order
+  for (i = 0; i < 1000; i++)
+    {
+      key = (i * 7919) % 1000;
+      if (skiplist_insert(list, key, VALUE(key)) != 0)
+        return 0;
+    }
+
+  if (skiplist_insert(list, 500, NULL) != -1 || skiplist_find(list, 500, &value) != 0
+      || value != VALUE(500) || skiplist_find(list, 1000, &value) != -1)
+    return 0;
+
+  return check_keys(0, 1000, 1) && check_keys(250, 750, 1)
+      && skiplist_range(list, 750, 250, NULL, NULL, 64) == 0;
+}
+
+int
+test_remove()
+{
+  void *value;
+  size_t i;
+
+  for (i = 0; i < 1000; i++)
+    skiplist_insert(list, i, VALUE(i));
+
+  // Remove the even keys; each can only be removed once
+  for (i = 0; i < 1000; i += 2)
+    if (skiplist_remove(list, i, &value) != 0 || value != VALUE(i)
+        || skiplist_remove(list, i, NULL) != -1)
+      return 0;
+
+  for (i = 0; i < 1000; i++)
+    if ((skiplist_find(list, i, NULL) == 0) != (i % 2 == 1))
+      return 0;
+
+  // Removed keys can be inserted again
+  if (skiplist_insert(list, 0, VALUE(0)) != 0 || skiplist_find(list, 0, NULL) != 0
+      || skiplist_remove(list, 0, NULL) != 0)
+    return 0;
+
+  return check_keys(1, 1000, 2);
+}
+
+static void*
+thread_test_insert(void* arg)
+{
+  thread_test_args_t *args = arg;
+  size_t i;
+
+  // Threads interleave their keys, so that they insert next to each other
+  for (i = args->id; i < NB_KEYS; i += NB_THREADS)
+    if (skiplist_insert(list, i, VALUE(i)) != 0)
+      return (void*)-1;
+
+  return (void*)0;
+}
+
+int
+test_insert_safe()
+{
+  thread_test_args_t args[NB_THREADS];
+
+  // Make sure no key is lost when several threads insert concurrently
+  if (run_test_function(&thread_test_insert, args) != 0)
+    return 0;
+
+  return check_keys(0, NB_KEYS, 1);
+}
+
+static void*
+thread_test_remove(void* arg)
+{
+  thread_test_args_t *args = arg;
+  size_t i;
+
+  // Every thread tries to remove every key, starting at different places
+  for (i = 0; i < NB_KEYS; i++)
+    if (skiplist_remove(list, (i + args->id * MAX_PUSH_POP) % NB_KEYS, NULL) == 0)
+      args->count++;
+
+  return (void*)0;
+}
+
+int
+test_remove_safe()
+{
+  thread_test_args_t args[NB_THREADS];
+  size_t i, counter = 0;
+
+  for (i = 0; i < NB_KEYS; i++)
+    skiplist_insert(list, i, VALUE(i));
+
+  // Each key is removed by exactly one thread
+  if (run_test_function(&thread_test_remove, args) != 0)
+    return 0;
+
+  for (i = 0; i < NB_THREADS; i++)
+    counter += args[i].count;
+
+  return counter == NB_KEYS && skiplist_range(list, 0, NB_KEYS, &i, NULL, 1) == 0;
+}
+
+static void*
+thread_test_churn(void* arg)
+{
+  thread_test_args_t *args = arg;
+  size_t i, key, keys[16];
+  void *value;
+
+  // Insert and remove odd keys while the even ones must stay visible to
+  // lookups and scans
+  for (i = 0; i < MAX_PUSH_POP; i++)
+    {
+      key = 2 * (i * NB_THREADS + args->id) + 1;
+      if (skiplist_insert(list, key, VALUE(key)) != 0)
+        return (void*)-1;
+      if (skiplist_find(list, key - 1, &value) != 0 || value != VALUE(key - 1))
+        return (void*)-1;
+      if (skiplist_range(list, key - 1, key + 1, keys, NULL, 16) < 2 || keys[0] != key - 1)
+        return (void*)-1;
+      if (skiplist_remove(list, key, &value) != 0 || value != VALUE(key))
+        return (void*)-1;
+    }
+
+  return (void*)0;
+}
+
+int
+test_churn()
+{
+  thread_test_args_t args[NB_THREADS];
+  size_t i;
+
+  for (i = 0; i <= 2 * NB_KEYS; i += 2)
+    skiplist_insert(list, i, VALUE(i));
+
+  if (run_test_function(&thread_test_churn, args) != 0)
+    return 0;
+
+  return check_keys(0, 2 * NB_KEYS, 2);
+}
+
+// Skip list performance test
+#if MEASURE != 0
+struct skiplist_measure_arg
+{
+  int id;
+};
+typedef struct skiplist_measure_arg skiplist_measure_arg_t;
+
+struct timespec t_start[NB_THREADS], t_stop[NB_THREADS], start, stop;
+
+static void*
+thread_test_performance(void* data)
+{
+  skiplist_measure_arg_t* arg = (skiplist_measure_arg_t*)data;
+  size_t key;
+  int i;
+
+  for (i = 0; i < MAX_PUSH_POP/NB_THREADS; i++)
+    {
+      key = (size_t)i * NB_THREADS + arg->id;
+#if MEASURE == 1
+      if (skiplist_insert(list, key, VALUE(key)) != 0)
+        return (void*)-1;
+#elif MEASURE == 2
+      if (skiplist_remove(list, key, NULL) != 0)
+        return (void*)-1;
+#else
+      // Lookups, with one insert and one remove in twenty operations
+      if (i % 20 == 0)
+        skiplist_insert(list, MAX_PUSH_POP + key, VALUE(key));
+      else if (i % 20 == 10)
+        skiplist_remove(list, MAX_PUSH_POP + key - 10 * NB_THREADS, NULL);
+      else if (skiplist_find(list, (key * 7919) % MAX_PUSH_POP, NULL) != 0)
+        return (void*)-1;
+#endif
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &t_stop[arg->id]);
+  return (void*)0;
+}
+#endif
+
+int
+main(int argc, char **argv)
+{
+setbuf(stdout, NULL);
+// MEASURE == 0 -> run unit tests
+#if MEASURE == 0
+  test_init();
+
+  test_run(test_order);
+  test_run(test_remove);
+  test_run(test_insert_safe);
+  test_run(test_remove_safe);
+  test_run(test_churn);
+
+  test_finalize();
+#else
+  // Run performance tests
+  int i;
+  skiplist_measure_arg_t arg[NB_THREADS];
+  pthread_attr_t attr;
+  pthread_t thread[NB_THREADS];
+
+  test_setup();
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      arg[i].id = i;
+      clock_gettime(CLOCK_MONOTONIC, &t_start[i]);
+      pthread_create(&thread[i], &attr, &thread_test_performance, &arg[i]);
+    }
+
+  // Wait for all threads to finish
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      pthread_join(thread[i], NULL);
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+
+  // Print out results
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      printf("%i %i %li %i %li %i %li %i %li\n", i, (int) start.tv_sec,
+          start.tv_nsec, (int) stop.tv_sec, stop.tv_nsec,
+          (int) t_start[i].tv_sec, t_start[i].tv_nsec, (int) t_stop[i].tv_sec,
+          t_stop[i].tv_nsec);
+    }
+#endif
+
+  return 0;
+}
@@ -34,32 +34,220 @@
 
 #include "stack.h"
 #include "non_blocking.h"
+#include "backoff.h"
+#include "park.h"
+
+// Fields written by different threads sit on cache lines of their own, so
+// that a thread writing one does not take the line away from threads using
+// another. Use 128 on processors whose prefetcher fetches lines in pairs.
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+#endif
+// PADDING=0 packs the head, lock and parking lot together instead, for
+// comparisons (see c2c)
+#ifndef PADDING
+#define PADDING 1
+#endif
+#if PADDING
+#define PADDED __attribute__((aligned(CACHE_LINE_SIZE)))
+#else
+#define PADDED
+#endif
+
+// Attempts of stack_pop_wait() before parking
+#ifndef STACK_WAIT_SPINS
+#define STACK_WAIT_SPINS 128
+#endif
+
+#if NON_BLOCKING == 4
+// Number of slots where pushes and pops meet to cancel out
+#ifndef ELIMINATION_SIZE
+#define ELIMINATION_SIZE 16
+#endif
+// Number of polls before an offer in the elimination array is withdrawn
+#ifndef ELIMINATION_SPINS
+#define ELIMINATION_SPINS 256
+#endif
+#endif
+
+#if NODE_POOL
+#include "pool.h"
+#endif
+
+#if NON_BLOCKING == 5
+#include <sched.h>
+#include "registry.h"
+#endif
+
+#if RECLAIM == 1
+#include "hazard.h"
+#elif RECLAIM == 2
+#include "epoch.h"
+#endif
+
+#if STACK_STATS
+#include <time.h>
+#include "registry.h"
+#include "histogram.h"
+#endif
 
 struct stack
 {
-  stack_node_t *head;
+#if NON_BLOCKING == 3
+  tagged_ptr_t head PADDED;
+#else
+  stack_node_t *head PADDED;
+#endif
+  // Threads waiting in stack_pop_wait(); read by every push
+  struct park park PADDED;
+#if NON_BLOCKING == 5
+  // Flat combining: threads publish their operation in their own slot, and
+  // whoever takes the lock applies all published operations
+  volatile size_t lock PADDED;
+  struct combining_slot
+  {
+    volatile size_t op;
+    stack_node_t * volatile node;
+    stack_node_t * volatile last;
+    volatile size_t count;
+  } __attribute__((aligned(CACHE_LINE_SIZE))) slots[REGISTRY_MAX_THREADS];
+#endif
+#if NON_BLOCKING == 4
+  // Kept away from the head's cache line, as slots are written often
+  struct elimination_slot
+  {
+    volatile size_t word;
+  } __attribute__((aligned(CACHE_LINE_SIZE))) elimination[ELIMINATION_SIZE];
+#endif
 #if NON_BLOCKING == 0
 #warning Stacks are synchronized through locks
-  pthread_mutex_t mutex;
+  // Threads waiting for the lock spin on its line, not on the head's
+  pthread_mutex_t mutex PADDED;
 #else
 #if NON_BLOCKING == 1 
 #warning Stacks are synchronized through lock-based CAS
-  pthread_mutex_t lock;
+#elif NON_BLOCKING == 3
+#warning Stacks are synchronized through hardware double-width CAS on tagged pointers
+#elif NON_BLOCKING == 4
+#warning Stacks are synchronized through hardware CAS with elimination backoff
+#elif NON_BLOCKING == 5
+#warning Stacks are synchronized through flat combining
 #else
 #warning Stacks are synchronized through hardware CAS
 #endif
 #endif
 };
 
+#if NON_BLOCKING == 3
+// The head is a pointer tagged with a counter incremented by every
+// operation, so that a pop cannot succeed if the head was popped and pushed
+// again since the pop read it (ABA problem)
+typedef tagged_ptr_t stack_head_t;
+#define HEAD_NODE(head) ((stack_node_t*)(head).ptr)
+#else
+typedef stack_node_t *stack_head_t;
+#define HEAD_NODE(head) (head)
+#endif
+#define STACK_HEAD(stack) HEAD_NODE((stack)->head)
+
+// Read the head of the stack before dereferencing it. With hazard pointers,
+// the head is published in the first hazard slot until hazard_clear(0), so
+// that no other thread frees it meanwhile. With epochs, the whole pop is a
+// critical section instead, and reading the head extends its reservation
+// to the current epoch, see epoch.h.
+static inline stack_head_t
+stack_read_head(stack_t *stack)
+{
+  stack_head_t head;
+
+#if RECLAIM == 1
+  do {
+    head = stack->head;
+    hazard_protect(0, HEAD_NODE(head));
+  } while (HEAD_NODE(head) != STACK_HEAD(stack));
+#elif NON_BLOCKING == 3 && RECLAIM == 2
+  do {
+    head = stack->head;
+    // Pairs with the CAS that pushed the head, so that its prev is visible
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  } while (epoch_extend());
+#elif NON_BLOCKING == 3
+  head = stack->head;
+  // Pairs with the CAS that pushed the head, so that its prev is visible
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+#elif RECLAIM == 2
+  head = (stack_head_t)epoch_read((size_t*)&stack->head);
+#else
+  head = (stack_head_t)load_acquire((size_t*)&stack->head);
+#endif
+
+  return head;
+}
+
+// Retries of the CAS loops of the calling thread
+static __thread struct backoff_stats backoff_stats;
+
+#if STACK_STATS
+// Statistics of every thread, each on its own cache lines
+static struct stack_thread_stats
+{
+  struct stack_op_stats ops[STACK_OPS];
+} __attribute__((aligned(64))) thread_stats[REGISTRY_MAX_THREADS];
+
+// Clock and CAS loop counters of the calling thread when an operation began
+struct stack_stats_start
+{
+  struct timespec time;
+  struct backoff_stats backoff;
+};
+
+static inline void
+stack_stats_begin(struct stack_stats_start *start)
+{
+  start->backoff = backoff_stats;
+  clock_gettime(CLOCK_MONOTONIC, &start->time);
+}
+
+static void
+stack_stats_end(enum stack_op op, const struct stack_stats_start *start)
+{
+  struct stack_op_stats *stats = &thread_stats[registry_thread_id()].ops[op];
+  unsigned long retries = backoff_stats.retries - start->backoff.retries;
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  stats->operations++;
+  // Every CAS loop that ran ended with one successful attempt
+  stats->cas_attempts += backoff_stats.operations - start->backoff.operations + retries;
+  stats->cas_failures += retries;
+  stats->backoff_spins += backoff_stats.spins - start->backoff.spins;
+  if (retries > stats->max_retries)
+    stats->max_retries = retries;
+  histogram_record(&stats->latency,
+      (unsigned long)(now.tv_sec - start->time.tv_sec) * 1000000000UL
+      + now.tv_nsec - start->time.tv_nsec);
+}
+
+#define STACK_STATS_BEGIN() \
+  struct stack_stats_start stats_start; \
+  stack_stats_begin(&stats_start)
+#define STACK_STATS_END(op) stack_stats_end(op, &stats_start)
+#else
+#define STACK_STATS_BEGIN()
+#define STACK_STATS_END(op)
+#endif
+
 static int stack_init(stack_t *stack);
+static void stack_node_release(void *node);
 
 stack_t *
 stack_alloc(void)
 {
   stack_t *stack;
 
-  stack = malloc(sizeof(struct stack));
-  if (stack == NULL)
+  // malloc() only aligns to 16 bytes
+  if (posix_memalign((void**)&stack, CACHE_LINE_SIZE, sizeof(struct stack)) != 0)
     return NULL;
 
   if (stack_init(stack) != 0)
@@ -76,16 +264,26 @@ stack_init(stack_t *stack)
 {
   assert(stack != NULL);
 
+#if NON_BLOCKING == 3
+  stack->head.ptr = (size_t)NULL;
+  stack->head.tag = 0;
+#else
   stack->head = NULL;
+#endif
+
+  park_init(&stack->park);
+
+#if NON_BLOCKING == 4
+  memset(stack->elimination, 0, sizeof(stack->elimination));
+#elif NON_BLOCKING == 5
+  stack->lock = 0;
+  memset(stack->slots, 0, sizeof(stack->slots));
+#endif
 
 #if NON_BLOCKING == 0
   // Implement a lock_based stack
   if (pthread_mutex_init(&stack->mutex, NULL) != 0)
     return -1;
-#elif NON_BLOCKING == 1
-  // Implement a software CAS-based stack
-  if (pthread_mutex_init(&stack->lock, NULL) != 0)
-    return -1;
 #endif
 
   return 0;
@@ -99,21 +297,17 @@ stack_free(stack_t *stack)
   assert(stack != NULL);
 
   // Free all nodes
-  node = stack->head;
+  node = STACK_HEAD(stack);
   while (node != NULL)
   {
     stack_node_t *tmp = node->prev;
-    free(node);
+    stack_node_release(node);
     node = tmp;
   }
   
 #if NON_BLOCKING == 0
   if (pthread_mutex_destroy(&stack->mutex) == 0)
     return -1;
-#elif NON_BLOCKING == 1
-  // Implement a software CAS-based stack
-  if (pthread_mutex_destroy(&stack->lock) == 0)
-    return -1;
 #endif
 
   free(stack);
@@ -137,21 +331,326 @@ stack_check(stack_t *stack)
   return 0;
 }
 
+#if NODE_POOL
+// Nodes of all stacks come from one pool with a cache per thread, so that
+// pushing does not contend in malloc
+static pool_t *node_pool;
+static pthread_once_t node_pool_once = PTHREAD_ONCE_INIT;
+
+static void
+node_pool_init(void)
+{
+  node_pool = pool_create(sizeof(struct stack_node));
+}
+
+void
+stack_node_pool_stats(struct pool_stats *stats)
+{
+  pthread_once(&node_pool_once, node_pool_init);
+  pool_get_stats(node_pool, stats);
+}
+#endif
+
+void
+stack_backoff_stats(struct backoff_stats *stats)
+{
+  *stats = backoff_stats;
+}
+
+#if STACK_STATS
+void
+stack_stats(enum stack_op op, struct stack_op_stats *stats)
+{
+  int threads = registry_threads(), t;
+
+  memset(stats, 0, sizeof(*stats));
+  for (t = 0; t < threads; t++)
+  {
+    const struct stack_op_stats *thread = &thread_stats[t].ops[op];
+
+    stats->operations += thread->operations;
+    stats->cas_attempts += thread->cas_attempts;
+    stats->cas_failures += thread->cas_failures;
+    stats->backoff_spins += thread->backoff_spins;
+    if (thread->max_retries > stats->max_retries)
+      stats->max_retries = thread->max_retries;
+    histogram_merge(&stats->latency, &thread->latency);
+  }
+}
+
+void
+stack_stats_reset(void)
+{
+  memset(thread_stats, 0, sizeof(thread_stats));
+}
+
+void
+stack_stats_dump(FILE *out)
+{
+  static const char *names[STACK_OPS] = { "push", "pop", "push_chain", "pop_bulk" };
+  struct stack_op_stats stats;
+  int op;
+
+  fprintf(out, "{\"non_blocking\": %d, \"reclaim\": %d, \"node_pool\": %d, "
+      "\"backoff\": %d", NON_BLOCKING, RECLAIM, NODE_POOL, BACKOFF);
+
+#if NODE_POOL
+  struct pool_stats pool;
+
+  stack_node_pool_stats(&pool);
+  fprintf(out, ", \"pool\": {\"slabs\": %lu, \"refills\": %lu, \"returns\": %lu}",
+      pool.slabs, pool.refills, pool.returns);
+#endif
+
+  for (op = 0; op < STACK_OPS; op++)
+  {
+    stack_stats(op, &stats);
+    fprintf(out, ", \"%s\": {\"operations\": %lu, \"cas_attempts\": %lu, "
+        "\"cas_failures\": %lu, \"backoff_spins\": %lu, \"max_retries\": %lu, "
+        "\"latency_ns\": ", names[op], stats.operations, stats.cas_attempts,
+        stats.cas_failures, stats.backoff_spins, stats.max_retries);
+    histogram_print_json(out, &stats.latency);
+    fprintf(out, "}");
+  }
+
+  fprintf(out, "}\n");
+}
+#endif
+
 stack_node_t *
 stack_node_alloc(void)
 {
   stack_node_t *node;
 
+#if NODE_POOL
+  if (node_pool == NULL)
+    pthread_once(&node_pool_once, node_pool_init);
+  node = pool_alloc(node_pool);
+  node->data = NULL;
+  node->prev = NULL;
+#else
   node = calloc(sizeof(struct stack_node), 1);
+#endif
+#if RECLAIM == 2
+  if (node != NULL)
+    node->birth = epoch_birth();
+#endif
   return node;
 }
 
+static void
+stack_node_release(void *node)
+{
+#if NODE_POOL
+  pool_free(node_pool, node);
+#else
+  free(node);
+#endif
+}
+
+#if NON_BLOCKING == 4
+// Elimination backoff (Hendler, Shavit and Yerushalmi, 2004). A push and a
+// pop that fail their CAS on the head may instead meet in a slot of the
+// elimination array, where the pop takes the node of the push and neither
+// touches the head. Each slot holds a node pointer whose two low bits tell
+// whether the slot is empty, has an offer waiting or is being answered.
+#define SLOT_EMPTY   0
+#define SLOT_WAITING 1
+#define SLOT_BUSY    2
+#define SLOT_STATE(word) ((word) & 3)
+#define SLOT_NODE(word) ((stack_node_t*)((word) & ~(size_t)3))
+
+// Offered by pops; never pushed
+static stack_node_t elimination_pop __attribute__((aligned(4)));
+#define ELIMINATION_POP (&elimination_pop)
+
+// Slots used by the calling thread, halved when offers time out and
+// doubled when slots are found busy
+static __thread unsigned int elimination_range = 1;
+static __thread unsigned int elimination_seed;
+
+static unsigned int
+elimination_slot(void)
+{
+  // xorshift, seeded from the address of the thread's own seed
+  unsigned int x = elimination_seed;
+
+  if (x == 0)
+    x = (unsigned int)(size_t)&elimination_seed | 1;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  elimination_seed = x;
+
+  return x % elimination_range;
+}
+
+// Exchange offer with another thread in a random slot. Returns the node
+// offered by the other thread, or NULL if nobody came.
+static stack_node_t *
+elimination_exchange(stack_t *stack, stack_node_t *offer)
+{
+  volatile size_t *slot = &stack->elimination[elimination_slot()].word;
+  size_t word = *slot, mine;
+  int i;
+
+  switch (SLOT_STATE(word))
+  {
+  case SLOT_EMPTY:
+    mine = (size_t)offer | SLOT_WAITING;
+    if (cas((size_t*)slot, word, mine) != word)
+      break;
+
+    for (i = 0; i < ELIMINATION_SPINS; i++)
+    {
+      word = *slot;
+      if (SLOT_STATE(word) == SLOT_BUSY)
+      {
+        *slot = SLOT_EMPTY;
+        return SLOT_NODE(word);
+      }
+    }
+
+    // Withdraw the offer unless it was answered meanwhile
+    if (cas((size_t*)slot, mine, SLOT_EMPTY) == mine)
+    {
+      if (elimination_range > 1)
+        elimination_range /= 2;
+      return NULL;
+    }
+    word = *slot;
+    *slot = SLOT_EMPTY;
+    return SLOT_NODE(word);
+
+  case SLOT_WAITING:
+    if (cas((size_t*)slot, word, (size_t)offer | SLOT_BUSY) == word)
+      return SLOT_NODE(word);
+    break;
+  }
+
+  // Contention on the slot; spread over more slots next time
+  if (elimination_range < ELIMINATION_SIZE)
+    elimination_range *= 2;
+  if (elimination_range > ELIMINATION_SIZE)
+    elimination_range = ELIMINATION_SIZE;
+
+  return NULL;
+}
+#endif
+
+#if NON_BLOCKING == 5
+// Flat combining (Hendler, Incze, Shavit and Tzafrir, 2010). The combiner
+// applies a whole batch of operations while it owns the head's cache line,
+// instead of every thread taking the lock and moving the line in turn.
+#define COMBINE_NONE 0
+#define COMBINE_PUSH 1
+#define COMBINE_POP  2
+
+// Polls of the own slot before giving the processor to the combiner
+#define COMBINE_SPINS 64
+
+static void
+flat_combine_all(stack_t *stack)
+{
+  int threads = registry_threads(), t;
+
+  for (t = 0; t < threads; t++)
+  {
+    struct combining_slot *slot = &stack->slots[t];
+    stack_node_t *node, *last;
+    size_t count;
+
+    // Pairs with the release of the request by its owner
+    switch (load_acquire((size_t*)&slot->op))
+    {
+    case COMBINE_PUSH:
+      // Push the chain from node to last
+      slot->last->prev = stack->head;
+      stack->head = slot->node;
+      break;
+    case COMBINE_POP:
+      slot->node = stack->head;
+      // All of them if count is 0: nobody reads how many, so the chain is
+      // not walked while every other request waits
+      if (slot->count == 0)
+      {
+        stack->head = NULL;
+        break;
+      }
+      // Else detach up to count nodes
+      node = stack->head;
+      last = NULL;
+      for (count = 0; node != NULL && count < slot->count; count++)
+      {
+        last = node;
+        node = node->prev;
+      }
+      if (last != NULL)
+        last->prev = NULL;
+      slot->count = count;
+      stack->head = node;
+      break;
+    default:
+      continue;
+    }
+
+    // The result must be visible before the owner sees its request done
+    store_release((size_t*)&slot->op, COMBINE_NONE);
+  }
+}
+
+// Publish a request and wait until a combiner, maybe the calling thread,
+// applied it. Returns the slot holding the result.
+static struct combining_slot *
+flat_combine(stack_t *stack, int op, stack_node_t *node, stack_node_t *last,
+    size_t count)
+{
+  struct combining_slot *slot = &stack->slots[registry_thread_id()];
+  int spins = 0;
+
+  slot->node = node;
+  slot->last = last;
+  slot->count = count;
+  // The arguments must be visible before the combiner sees the request
+  store_release((size_t*)&slot->op, op);
+
+  // Acquire the result along with the end of the request
+  while (load_acquire((size_t*)&slot->op) != COMBINE_NONE)
+  {
+    if (stack->lock == 0 && cas((size_t*)&stack->lock, 0, 1) == 0)
+    {
+      flat_combine_all(stack);
+      store_release((size_t*)&stack->lock, 0);
+    }
+    else if (++spins % COMBINE_SPINS == 0)
+      sched_yield();
+  }
+
+  return slot;
+}
+#endif
+
+void
+stack_node_free(stack_node_t *node)
+{
+#if RECLAIM == 1
+  // Other threads may still be reading node->prev in stack_pop()
+  hazard_retire(node, stack_node_release);
+#elif RECLAIM == 2
+  epoch_retire(node, node->birth, stack_node_release);
+#else
+  stack_node_release(node);
+#endif
+}
+
 int
 stack_push(stack_t *stack, stack_node_t* node)
 {
   assert(stack != NULL);
   assert(node != NULL);
 
+  STACK_STATS_BEGIN();
+
 #if NON_BLOCKING == 0
   // Implement a lock_based stack
   pthread_mutex_lock(&stack->mutex);
@@ -162,19 +661,64 @@ stack_push(stack_t *stack, stack_node_t* node)
   /*** Optional ***/
   // Implement a software CAS-based stack
   stack_node_t *head;
+  struct backoff backoff;
+  backoff_init(&backoff);
   do {
     head = stack->head;
     node->prev = head;
-  } while (software_cas((size_t*)&stack->head, (size_t)head, (size_t)node, &stack->lock) != (size_t)head);
+  } while (software_cas((size_t*)&stack->head, (size_t)head, (size_t)node) != (size_t)head &&
+      backoff_retry(&backoff));
+  backoff_account(&backoff_stats, &backoff);
+#elif NON_BLOCKING == 3
+  // Implement a hardware CAS-based stack with tagged pointers
+  tagged_ptr_t head, new_head;
+  struct backoff backoff;
+  backoff_init(&backoff);
+  do {
+    head = stack->head;
+    node->prev = (stack_node_t*)head.ptr;
+    new_head.ptr = (size_t)node;
+    new_head.tag = head.tag + 1;
+  } while (!tagged_ptr_equal(cas2(&stack->head, head, new_head), head) &&
+      backoff_retry(&backoff));
+  backoff_account(&backoff_stats, &backoff);
+#elif NON_BLOCKING == 4
+  // Implement a hardware CAS-based stack with elimination backoff
+  stack_node_t *head;
+  struct backoff backoff;
+  // Elimination is the backoff, so failures are only counted
+  for (backoff_init(&backoff);; backoff.retries++) {
+    head = stack->head;
+    node->prev = head;
+    if (cas_release((size_t*)&stack->head, (size_t)head, (size_t)node) == (size_t)head)
+      break;
+    // Done if a pop took the node
+    if (elimination_exchange(stack, node) == ELIMINATION_POP)
+      break;
+  }
+  backoff_account(&backoff_stats, &backoff);
+#elif NON_BLOCKING == 5
+  // Implement a flat-combining stack
+  flat_combine(stack, COMBINE_PUSH, node, node, 0);
 #else
   // Implement a hardware CAS-based stack
   stack_node_t *head;
+  struct backoff backoff;
+  backoff_init(&backoff);
   do {
     head = stack->head;
     node->prev = head;
-  } while (cas((size_t*)&stack->head, (size_t)head, (size_t)node) != (size_t)head);
+  } while (cas_release((size_t*)&stack->head, (size_t)head, (size_t)node) != (size_t)head &&
+      backoff_retry(&backoff));
+  backoff_account(&backoff_stats, &backoff);
 #endif
 
+  // The CAS or lock above orders the push before the check for sleepers,
+  // see park.h
+  park_wake_one(&stack->park);
+
+  STACK_STATS_END(STACK_OP_PUSH);
+
   return 0;
 }
 
@@ -185,6 +729,12 @@ stack_pop(stack_t *stack, stack_node_t** node)
 
   assert(stack != NULL);
 
+  STACK_STATS_BEGIN();
+
+#if RECLAIM == 2
+  epoch_enter();
+#endif
+
 #if NON_BLOCKING == 0
   // Implement a lock_based stack
   pthread_mutex_lock(&stack->mutex);
@@ -197,30 +747,343 @@ stack_pop(stack_t *stack, stack_node_t** node)
   /*** Optional ***/
   // Implement a software CAS-based stack
   stack_node_t *new_head;
+  struct backoff backoff;
+  backoff_init(&backoff);
   do {
-    popped = stack->head;
+    popped = stack_read_head(stack);
+    new_head = popped != NULL ? popped->prev : NULL;
+  } while (software_cas((size_t*)&stack->head, (size_t)popped, (size_t)new_head) != (size_t)popped &&
+      backoff_retry(&backoff));
+  backoff_account(&backoff_stats, &backoff);
+#elif NON_BLOCKING == 3
+  // Implement a hardware CAS-based stack with tagged pointers
+  tagged_ptr_t head, new_head;
+  struct backoff backoff;
+  backoff_init(&backoff);
+  do {
+    head = stack_read_head(stack);
+    popped = HEAD_NODE(head);
+    new_head.ptr = (size_t)(popped != NULL ? popped->prev : NULL);
+    new_head.tag = head.tag + 1;
+  } while (!tagged_ptr_equal(cas2(&stack->head, head, new_head), head) &&
+      backoff_retry(&backoff));
+  backoff_account(&backoff_stats, &backoff);
+#elif NON_BLOCKING == 4
+  // Implement a hardware CAS-based stack with elimination backoff
+  stack_node_t *new_head, *other;
+  struct backoff backoff;
+  for (backoff_init(&backoff);; backoff.retries++) {
+    popped = stack_read_head(stack);
     new_head = popped != NULL ? popped->prev : NULL;
-  } while (software_cas((size_t*)&stack->head, (size_t)popped, (size_t)new_head, &stack->lock) != (size_t)popped);
+    if (cas_acquire((size_t*)&stack->head, (size_t)popped, (size_t)new_head) == (size_t)popped)
+      break;
+    // Done if a push gave its node
+    other = elimination_exchange(stack, ELIMINATION_POP);
+    if (other != NULL && other != ELIMINATION_POP) {
+      popped = other;
+      break;
+    }
+  }
+  backoff_account(&backoff_stats, &backoff);
+#elif NON_BLOCKING == 5
+  // Implement a flat-combining stack
+  popped = flat_combine(stack, COMBINE_POP, NULL, NULL, 1)->node;
 #else
   // Implement a hardware CAS-based stack
   stack_node_t *new_head;
+  struct backoff backoff;
+  backoff_init(&backoff);
   do {
-    popped = stack->head;
+    popped = stack_read_head(stack);
     new_head = popped != NULL ? popped->prev : NULL;
-  } while (cas((size_t*)&stack->head, (size_t)popped, (size_t)new_head) != (size_t)popped);
+  } while (cas_acquire((size_t*)&stack->head, (size_t)popped, (size_t)new_head) != (size_t)popped &&
+      backoff_retry(&backoff));
+  backoff_account(&backoff_stats, &backoff);
 #endif
 
+#if RECLAIM == 1
+  hazard_clear(0);
+#elif RECLAIM == 2
+  epoch_exit();
+#endif
+
+  STACK_STATS_END(STACK_OP_POP);
+
   if (popped == NULL)
     return -1;
 
   if (node != NULL)
     *node = popped;
   else
-    free(popped);
+    stack_node_free(popped);
 
   return 0;
 }
 
+int
+stack_pop_wait(stack_t *stack, stack_node_t **node, long timeout_us)
+{
+  struct timespec deadline;
+  int i, ticket, interrupts;
+
+  interrupts = park_interrupts(&stack->park);
+
+  // Nodes often come soon, so spin a little before sleeping
+  for (i = 0; i < STACK_WAIT_SPINS; i++)
+  {
+    if (stack_pop(stack, node) == 0)
+      return 0;
+    cpu_relax();
+  }
+
+  if (timeout_us >= 0)
+    park_deadline(&deadline, timeout_us);
+
+  // Wakeups may be spurious or meant for a node another thread took
+  // first, so wait again until the one deadline
+  for (;;)
+  {
+    ticket = park_prepare(&stack->park);
+    if (stack_pop(stack, node) == 0)
+    {
+      park_cancel(&stack->park);
+      return 0;
+    }
+    if (park_interrupts(&stack->park) != interrupts)
+    {
+      park_cancel(&stack->park);
+      return 1;
+    }
+    if (park_wait(&stack->park, ticket, timeout_us >= 0 ? &deadline : NULL) != 0)
+      return stack_pop(stack, node) == 0 ? 0 : -1;
+  }
+}
+
+void
+stack_wake_all(stack_t *stack)
+{
+  park_interrupt(&stack->park);
+}
+
+#if NON_BLOCKING == 1
+#define STACK_CAS(stack, old, new) \
+  software_cas((size_t*)&(stack)->head, (size_t)(old), (size_t)(new))
+#elif NON_BLOCKING != 3
+// Bulk pops take ownership and bulk pushes publish, hence both orders
+#define STACK_CAS(stack, old, new) \
+  cas((size_t*)&(stack)->head, (size_t)(old), (size_t)(new))
+#endif
+
+int
+stack_push_chain(stack_t *stack, stack_node_t *first, stack_node_t *last)
+{
+  assert(stack != NULL);
+  assert(first != NULL && last != NULL);
+
+  STACK_STATS_BEGIN();
+
+  // Nodes from first to last are linked through prev; last takes the place
+  // of a single pushed node
+#if NON_BLOCKING == 0
+  pthread_mutex_lock(&stack->mutex);
+  last->prev = stack->head;
+  stack->head = first;
+  pthread_mutex_unlock(&stack->mutex);
+#elif NON_BLOCKING == 3
+  tagged_ptr_t head, new_head;
+  struct backoff backoff;
+  backoff_init(&backoff);
+  do {
+    head = stack->head;
+    last->prev = HEAD_NODE(head);
+    new_head.ptr = (size_t)first;
+    new_head.tag = head.tag + 1;
+  } while (!tagged_ptr_equal(cas2(&stack->head, head, new_head), head) &&
+      backoff_retry(&backoff));
+  backoff_account(&backoff_stats, &backoff);
+#elif NON_BLOCKING == 5
+  flat_combine(stack, COMBINE_PUSH, first, last, 0);
+#else
+  stack_node_t *head;
+  struct backoff backoff;
+  backoff_init(&backoff);
+  do {
+    head = stack->head;
+    last->prev = head;
+  } while (STACK_CAS(stack, head, first) != (size_t)head && backoff_retry(&backoff));
+  backoff_account(&backoff_stats, &backoff);
+#endif
+
+  // The chain may feed several waiters
+  park_wake_all(&stack->park);
+
+  STACK_STATS_END(STACK_OP_PUSH_CHAIN);
+
+  return 0;
+}
+
+int
+stack_pop_all(stack_t *stack, stack_node_t **first)
+{
+  stack_node_t *popped;
+
+  assert(stack != NULL);
+  assert(first != NULL);
+
+  STACK_STATS_BEGIN();
+
+  // Nothing is dereferenced, so nodes need no protection
+#if NON_BLOCKING == 0
+  pthread_mutex_lock(&stack->mutex);
+  popped = stack->head;
+  stack->head = NULL;
+  pthread_mutex_unlock(&stack->mutex);
+#elif NON_BLOCKING == 3
+  tagged_ptr_t head, new_head;
+  struct backoff backoff;
+  backoff_init(&backoff);
+  do {
+    head = stack->head;
+    popped = HEAD_NODE(head);
+    if (popped == NULL)
+      break;
+    new_head.ptr = (size_t)NULL;
+    new_head.tag = head.tag + 1;
+  } while (!tagged_ptr_equal(cas2(&stack->head, head, new_head), head) &&
+      backoff_retry(&backoff));
+  backoff_account(&backoff_stats, &backoff);
+#elif NON_BLOCKING == 5
+  popped = flat_combine(stack, COMBINE_POP, NULL, NULL, 0)->node;
+#else
+  struct backoff backoff;
+  backoff_init(&backoff);
+  do {
+    popped = stack->head;
+    if (popped == NULL)
+      break;
+  } while (STACK_CAS(stack, popped, NULL) != (size_t)popped && backoff_retry(&backoff));
+  backoff_account(&backoff_stats, &backoff);
+#endif
+
+  STACK_STATS_END(STACK_OP_POP_BULK);
+
+  *first = popped;
+
+  return popped == NULL ? -1 : 0;
+}
+
+#if NON_BLOCKING != 5
+// Find the n-th node from head, or the last one if there are fewer, and
+// count the nodes on the way. Returns NULL if head is not the head of the
+// stack anymore, as the nodes below it may be gone.
+static stack_node_t *
+stack_walk(stack_t *stack, stack_node_t *head, size_t n, size_t *count)
+{
+  stack_node_t *last = head, *next;
+
+  for (*count = 1; *count < n; (*count)++)
+  {
+#if RECLAIM == 2
+    next = (stack_node_t*)epoch_read((size_t*)&last->prev);
+#else
+    next = last->prev;
+#endif
+    if (next == NULL)
+      break;
+#if RECLAIM == 1
+    // As long as head is in the stack, so is every node below it. Nodes
+    // are published one after another in the second hazard slot.
+    hazard_protect(1, next);
+    if (STACK_HEAD(stack) != head)
+      return NULL;
+#endif
+    last = next;
+  }
+
+  return last;
+}
+#endif
+
+size_t
+stack_pop_n(stack_t *stack, size_t n, stack_node_t **first)
+{
+  stack_node_t *popped = NULL, *last = NULL;
+  size_t count = 0;
+
+  assert(stack != NULL);
+  assert(first != NULL);
+
+  *first = NULL;
+  if (n == 0)
+    return 0;
+
+  STACK_STATS_BEGIN();
+
+#if RECLAIM == 2
+  epoch_enter();
+#endif
+
+#if NON_BLOCKING == 0
+  pthread_mutex_lock(&stack->mutex);
+  popped = stack->head;
+  if (popped != NULL) {
+    last = stack_walk(stack, popped, n, &count);
+    stack->head = last->prev;
+  }
+  pthread_mutex_unlock(&stack->mutex);
+#elif NON_BLOCKING == 3
+  tagged_ptr_t head, new_head;
+  struct backoff backoff;
+  for (backoff_init(&backoff);; backoff_retry(&backoff)) {
+    head = stack_read_head(stack);
+    popped = HEAD_NODE(head);
+    if (popped == NULL)
+      break;
+    last = stack_walk(stack, popped, n, &count);
+    if (last == NULL)
+      continue;
+    new_head.ptr = (size_t)last->prev;
+    new_head.tag = head.tag + 1;
+    if (tagged_ptr_equal(cas2(&stack->head, head, new_head), head))
+      break;
+  }
+  backoff_account(&backoff_stats, &backoff);
+#elif NON_BLOCKING == 5
+  struct combining_slot *slot = flat_combine(stack, COMBINE_POP, NULL, NULL, n);
+  popped = slot->node;
+  count = slot->count;
+#else
+  struct backoff backoff;
+  for (backoff_init(&backoff);; backoff_retry(&backoff)) {
+    popped = stack_read_head(stack);
+    if (popped == NULL)
+      break;
+    last = stack_walk(stack, popped, n, &count);
+    if (last != NULL && STACK_CAS(stack, popped, last->prev) == (size_t)popped)
+      break;
+  }
+  backoff_account(&backoff_stats, &backoff);
+#endif
+
+#if RECLAIM == 1
+  hazard_clear(1);
+  hazard_clear(0);
+#elif RECLAIM == 2
+  epoch_exit();
+#endif
+
+  STACK_STATS_END(STACK_OP_POP_BULK);
+
+  if (popped == NULL)
+    return 0;
+
+  if (last != NULL)
+    last->prev = NULL;
+  *first = popped;
+
+  return count;
+}
+
 static void
 aba_helper(sem_t* read_a_sem, sem_t* reinsert_a_sem)
 {
@@ -243,6 +1106,10 @@ stack_pop_aba(stack_t *stack, stack_node_t** node,
 
   assert(stack != NULL);
 
+#if RECLAIM == 2
+  epoch_enter();
+#endif
+
 #if NON_BLOCKING == 0
   // Implement a lock_based stack
   pthread_mutex_lock(&stack->mutex);
@@ -256,18 +1123,37 @@ stack_pop_aba(stack_t *stack, stack_node_t** node,
   // Implement a software CAS-based stack
   stack_node_t *new_head;
   do {
-    popped = stack->head;
+    popped = stack_read_head(stack);
     new_head = popped != NULL ? popped->prev : NULL;
 
     // Code to enable test of ABA problem
     aba_helper(read_a_sem, reinsert_a_sem);
 
-  } while (software_cas((size_t*)&stack->head, (size_t)popped, (size_t)new_head, &stack->lock) != (size_t)popped);
+  } while (software_cas((size_t*)&stack->head, (size_t)popped, (size_t)new_head) != (size_t)popped);
+#elif NON_BLOCKING == 3
+  // Implement a hardware CAS-based stack with tagged pointers
+  tagged_ptr_t head, new_head;
+  int first_attempt = 1;
+  do {
+    head = stack_read_head(stack);
+    popped = HEAD_NODE(head);
+    new_head.ptr = (size_t)(popped != NULL ? popped->prev : NULL);
+    new_head.tag = head.tag + 1;
+
+    // Code to enable test of ABA problem. The first attempt is expected to
+    // fail, and the other thread does not interfere with the next ones.
+    if (first_attempt)
+      aba_helper(read_a_sem, reinsert_a_sem);
+    first_attempt = 0;
+
+  } while (!tagged_ptr_equal(cas2(&stack->head, head, new_head), head));
 #else
-  // Implement a hardware CAS-based stack
+  // Implement a hardware CAS-based stack. Elimination and flat combining
+  // stacks pop the same way here, as the test runs no other operation
+  // concurrently with the CAS.
   stack_node_t *new_head;
   do {
-    popped = stack->head;
+    popped = stack_read_head(stack);
     new_head = popped != NULL ? popped->prev : NULL;
 
     // Code to enable test of ABA problem
@@ -276,13 +1162,19 @@ stack_pop_aba(stack_t *stack, stack_node_t** node,
   } while (cas((size_t*)&stack->head, (size_t)popped, (size_t)new_head) != (size_t)popped);
 #endif
 
+#if RECLAIM == 1
+  hazard_clear(0);
+#elif RECLAIM == 2
+  epoch_exit();
+#endif
+
   if (popped == NULL)
     return -1;
 
   if (node != NULL)
     *node = popped;
   else
-    free(popped);
+    stack_node_free(popped);
 
   return 0;
 }
@@ -295,7 +1187,7 @@ void stack_print_aba(stack_t *stack)
   assert(stack != NULL);
 
   printf("Stack: ");
-  node = stack->head;
+  node = STACK_HEAD(stack);
   
   while (node != NULL) {
     printf("%s -> ", (char*)node->data);
@@ -304,3 +1196,27 @@ void stack_print_aba(stack_t *stack)
   printf("NULL\n");
 }
 
+#if NON_BLOCKING == 0
+#define STACK_VARIANT_NAME "lock"
+#elif NON_BLOCKING == 1
+#define STACK_VARIANT_NAME "software-cas"
+#elif NON_BLOCKING == 3
+#define STACK_VARIANT_NAME "tagged-cas"
+#elif NON_BLOCKING == 4
+#define STACK_VARIANT_NAME "elimination"
+#elif NON_BLOCKING == 5
+#define STACK_VARIANT_NAME "flat-combining"
+#else
+#define STACK_VARIANT_NAME "cas"
+#endif
+
+const struct stack_ops stack_variant =
+{
+  .name = STACK_VARIANT_NAME,
+  .alloc = stack_alloc,
+  .free = stack_free,
+  .node_alloc = stack_node_alloc,
+  .node_free = stack_node_free,
+  .push = stack_push,
+  .pop = stack_pop,
+};
@@ -28,10 +28,54 @@
 #ifndef STACK_H
 #define STACK_H
 
+// Compiling stack.c with STACK_NAMESPACE=ns prefixes its functions with ns_,
+// so that stacks of several NON_BLOCKING variants can be linked in one
+// program and chosen at run time through their stack_variant
+#ifdef STACK_NAMESPACE
+#define STACK_PASTE(ns, name) ns##_##name
+#define STACK_SYMBOL_(ns, name) STACK_PASTE(ns, name)
+#define STACK_SYMBOL(name) STACK_SYMBOL_(STACK_NAMESPACE, name)
+#define stack_alloc           STACK_SYMBOL(stack_alloc)
+#define stack_free            STACK_SYMBOL(stack_free)
+#define stack_node_alloc      STACK_SYMBOL(stack_node_alloc)
+#define stack_node_free       STACK_SYMBOL(stack_node_free)
+#define stack_node_pool_stats STACK_SYMBOL(stack_node_pool_stats)
+#define stack_push            STACK_SYMBOL(stack_push)
+#define stack_pop             STACK_SYMBOL(stack_pop)
+#define stack_pop_wait        STACK_SYMBOL(stack_pop_wait)
+#define stack_wake_all        STACK_SYMBOL(stack_wake_all)
+#define stack_push_chain      STACK_SYMBOL(stack_push_chain)
+#define stack_pop_all         STACK_SYMBOL(stack_pop_all)
+#define stack_pop_n           STACK_SYMBOL(stack_pop_n)
+#define stack_pop_aba         STACK_SYMBOL(stack_pop_aba)
+#define stack_print_aba       STACK_SYMBOL(stack_print_aba)
+#define stack_backoff_stats   STACK_SYMBOL(stack_backoff_stats)
+#define stack_check           STACK_SYMBOL(stack_check)
+#define stack_stats           STACK_SYMBOL(stack_stats)
+#define stack_stats_reset     STACK_SYMBOL(stack_stats_reset)
+#define stack_stats_dump      STACK_SYMBOL(stack_stats_dump)
+#define stack_variant         STACK_SYMBOL(stack_variant)
+#endif
+
+#include "backoff.h"
+
+#if NODE_POOL
+#include "pool.h"
+#endif
+
+#if STACK_STATS
+#include <stdio.h>
+#include "histogram.h"
+#endif
+
 struct stack_node
 {
   void *data;
   struct stack_node *prev;
+#if RECLAIM == 2
+  // Epoch the node was allocated in, see epoch.h
+  size_t birth;
+#endif
 };
 typedef struct stack_node stack_node_t;
 
@@ -41,16 +85,81 @@ stack_t * stack_alloc(void);
 int       stack_free(stack_t *stack);
 
 stack_node_t * stack_node_alloc(void);
+// Give back a node popped from a stack; the node must not be pushed again
+void           stack_node_free(stack_node_t *node);
+#if NODE_POOL
+void           stack_node_pool_stats(struct pool_stats *stats);
+#endif
 
 int       stack_push(stack_t *stack, stack_node_t* node);
 int       stack_pop(stack_t *stack, stack_node_t** node);
+// Pop, waiting up to timeout_us microseconds, or forever if negative, for
+// a node to be pushed. Idle waiters sleep until a push wakes one of them.
+// Returns 0 with a node, -1 once the timeout passed without one, or 1 if
+// stack_wake_all() was called since this call began.
+int       stack_pop_wait(stack_t *stack, stack_node_t **node, long timeout_us);
+// Make every waiter return 1, e.g. so that they notice there is no more work
+void      stack_wake_all(stack_t *stack);
+
+// Bulk operations, one synchronization each. Chains are linked through
+// prev from first to last, and last->prev is NULL in detached chains.
+int       stack_push_chain(stack_t *stack, stack_node_t *first, stack_node_t *last);
+int       stack_pop_all(stack_t *stack, stack_node_t **first);
+// Detach up to n nodes; returns how many
+size_t    stack_pop_n(stack_t *stack, size_t n, stack_node_t **first);
 
 int       stack_pop_aba(stack_t *stack, stack_node_t** node,
                         sem_t* read_a_sem, sem_t* reinsert_a_sem);
 
 void      stack_print_aba(stack_t *stack);
 
+// Operations and retries in CAS loops of the calling thread so far
+void      stack_backoff_stats(struct backoff_stats *stats);
+
+#if STACK_STATS
+// Counters and latencies in nanoseconds of every operation, kept per
+// thread and summed over all threads when read
+enum stack_op
+{
+  STACK_OP_PUSH,
+  STACK_OP_POP,
+  STACK_OP_PUSH_CHAIN,
+  STACK_OP_POP_BULK,  // stack_pop_all() and stack_pop_n()
+  STACK_OPS
+};
+
+struct stack_op_stats
+{
+  unsigned long operations;
+  unsigned long cas_attempts;
+  unsigned long cas_failures;
+  unsigned long backoff_spins;  // pause instructions waited after failures
+  unsigned long max_retries;
+  struct histogram latency;
+};
+
+// Exact once the threads using stacks are done
+void      stack_stats(enum stack_op op, struct stack_op_stats *stats);
+// Forget everything recorded so far, while no thread uses stacks
+void      stack_stats_reset(void);
+// All counters and node pool statistics as a JSON object
+void      stack_stats_dump(FILE *out);
+#endif
+
 int       stack_check(stack_t *stack);
 
+// The basic operations of the variant compiled in, with its name
+struct stack_ops
+{
+  const char *name;
+  stack_t *      (*alloc)(void);
+  int            (*free)(stack_t *stack);
+  stack_node_t * (*node_alloc)(void);
+  void           (*node_free)(stack_node_t *node);
+  int            (*push)(stack_t *stack, stack_node_t *node);
+  int            (*pop)(stack_t *stack, stack_node_t **node);
+};
+extern const struct stack_ops stack_variant;
+
 
 #endif /* STACK_H */
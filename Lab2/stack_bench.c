@@ -0,0 +1,664 @@
+/*
+ * stack_bench.c
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ * 
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ * 
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ * 
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+
+// Throughput of every stack variant, of the queues and of the ordered sets
+// under the same load, swept at run time over thread counts, shares of
+// lookups and pushes, prefill sizes and think times. Every thread picks an
+// operation at random for a fixed duration; the program prints one line
+// per run with the throughput, how evenly threads progressed and how well
+// throughput scales.
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <search.h>
+
+#include "stack.h"
+#include "queue.h"
+#include "ring.h"
+#include "skiplist.h"
+#include "pqueue.h"
+#include "backoff.h"
+
+#define MAX_VALUES 32
+#define MAX_THREADS 128
+
+#define DEFAULT_DURATION_MS 200
+#define DEFAULT_PREFILL 1000
+#define DEFAULT_PUSH_PERCENT 50
+#define DEFAULT_LOOKUP_PERCENT 0
+#define DEFAULT_THINK 0
+#define DEFAULT_TRIES 1
+
+// Rings are sized for the prefill, but at least this large
+#define RING_MIN_CAPACITY (1 << 20)
+
+// Stack variants, each compiled from stack.c with its own namespace
+extern const struct stack_ops nb0_stack_variant, nb1_stack_variant,
+    nb2_stack_variant, nb3_stack_variant, nb4_stack_variant, nb5_stack_variant;
+
+// Common interface of stacks, queues and sets: put and get return -1 if
+// the container is full or empty. Sets use data as the key, so that put
+// fails if the key is present and get removes the given key or fails if it
+// is absent; stacks and queues ignore the key. Only sets can find keys.
+struct variant
+{
+  const char *name;
+  void * (*create)(const struct variant *variant, size_t prefill);
+  void   (*destroy)(void *container);
+  int    (*put)(void *container, void *data);
+  int    (*get)(void *container, void *key, void **data);
+  int    (*find)(void *container, void *key);
+  const struct stack_ops *stack;
+};
+
+struct bench_stack
+{
+  const struct stack_ops *ops;
+  stack_t *stack;
+};
+
+static void *
+bench_stack_create(const struct variant *variant, size_t prefill)
+{
+  struct bench_stack *container = malloc(sizeof(struct bench_stack));
+
+  container->ops = variant->stack;
+  container->stack = variant->stack->alloc();
+
+  return container;
+}
+
+static void
+bench_stack_destroy(void *container)
+{
+  struct bench_stack *bench = container;
+
+  bench->ops->free(bench->stack);
+  free(bench);
+}
+
+static int
+bench_stack_put(void *container, void *data)
+{
+  struct bench_stack *bench = container;
+  stack_node_t *node = bench->ops->node_alloc();
+
+  node->data = data;
+  return bench->ops->push(bench->stack, node);
+}
+
+static int
+bench_stack_get(void *container, void *key, void **data)
+{
+  struct bench_stack *bench = container;
+  stack_node_t *node;
+
+  if (bench->ops->pop(bench->stack, &node) != 0)
+    return -1;
+
+  *data = node->data;
+  bench->ops->node_free(node);
+
+  return 0;
+}
+
+static void *
+bench_queue_create(const struct variant *variant, size_t prefill)
+{
+  return queue_alloc();
+}
+
+static void
+bench_queue_destroy(void *container)
+{
+  queue_free(container);
+}
+
+static int
+bench_queue_put(void *container, void *data)
+{
+  return queue_enqueue(container, data);
+}
+
+static int
+bench_queue_get(void *container, void *key, void **data)
+{
+  return queue_dequeue(container, data);
+}
+
+static void *
+bench_ring_create(const struct variant *variant, size_t prefill)
+{
+  return ring_alloc(2 * prefill > RING_MIN_CAPACITY ? 2 * prefill : RING_MIN_CAPACITY);
+}
+
+static void
+bench_ring_destroy(void *container)
+{
+  ring_free(container);
+}
+
+static int
+bench_ring_put(void *container, void *data)
+{
+  return ring_enqueue(container, data);
+}
+
+static int
+bench_ring_get(void *container, void *key, void **data)
+{
+  return ring_dequeue(container, data);
+}
+
+static void *
+bench_skiplist_create(const struct variant *variant, size_t prefill)
+{
+  return skiplist_alloc();
+}
+
+static void
+bench_skiplist_destroy(void *container)
+{
+  skiplist_free(container);
+}
+
+static int
+bench_skiplist_put(void *container, void *data)
+{
+  return skiplist_insert(container, (size_t)data, data);
+}
+
+static int
+bench_skiplist_get(void *container, void *key, void **data)
+{
+  return skiplist_remove(container, (size_t)key, data);
+}
+
+static int
+bench_skiplist_find(void *container, void *key)
+{
+  return skiplist_find(container, (size_t)key, NULL);
+}
+
+static void *
+bench_pqueue_create(const struct variant *variant, size_t prefill)
+{
+  return pqueue_alloc(0);
+}
+
+static void
+bench_pqueue_destroy(void *container)
+{
+  pqueue_free(container);
+}
+
+// Priority queues use the key as priority
+static int
+bench_pqueue_put(void *container, void *data)
+{
+  return pqueue_insert(container, (size_t)data, data);
+}
+
+static int
+bench_pqueue_get(void *container, void *key, void **data)
+{
+  return pqueue_delete_min(container, NULL, data);
+}
+
+// Baseline for the skip list: the C library's balanced tree (a red-black
+// tree in glibc) behind a mutex
+struct bench_tree
+{
+  pthread_mutex_t lock;
+  void *root;
+};
+
+static int
+bench_tree_compare(const void *a, const void *b)
+{
+  return (size_t)a < (size_t)b ? -1 : (size_t)a > (size_t)b;
+}
+
+static void
+bench_tree_keep(void *key)
+{
+  // Keys are not allocated
+}
+
+static void *
+bench_tree_create(const struct variant *variant, size_t prefill)
+{
+  struct bench_tree *tree = malloc(sizeof(struct bench_tree));
+
+  pthread_mutex_init(&tree->lock, NULL);
+  tree->root = NULL;
+
+  return tree;
+}
+
+static void
+bench_tree_destroy(void *container)
+{
+  struct bench_tree *tree = container;
+
+  tdestroy(tree->root, bench_tree_keep);
+  pthread_mutex_destroy(&tree->lock);
+  free(tree);
+}
+
+static int
+bench_tree_put(void *container, void *data)
+{
+  struct bench_tree *tree = container;
+  int present;
+
+  pthread_mutex_lock(&tree->lock);
+  present = tfind(data, &tree->root, bench_tree_compare) != NULL;
+  if (!present)
+    tsearch(data, &tree->root, bench_tree_compare);
+  pthread_mutex_unlock(&tree->lock);
+
+  return present ? -1 : 0;
+}
+
+static int
+bench_tree_get(void *container, void *key, void **data)
+{
+  struct bench_tree *tree = container;
+  int present;
+
+  pthread_mutex_lock(&tree->lock);
+  present = tdelete(key, &tree->root, bench_tree_compare) != NULL;
+  pthread_mutex_unlock(&tree->lock);
+
+  *data = key;
+  return present ? 0 : -1;
+}
+
+static int
+bench_tree_find(void *container, void *key)
+{
+  struct bench_tree *tree = container;
+  int present;
+
+  pthread_mutex_lock(&tree->lock);
+  present = tfind(key, &tree->root, bench_tree_compare) != NULL;
+  pthread_mutex_unlock(&tree->lock);
+
+  return present ? 0 : -1;
+}
+
+#define STACK_VARIANT(ops) \
+  { NULL, bench_stack_create, bench_stack_destroy, bench_stack_put, bench_stack_get, NULL, &(ops) }
+
+static struct variant variants[] =
+{
+  STACK_VARIANT(nb0_stack_variant),
+  STACK_VARIANT(nb1_stack_variant),
+  STACK_VARIANT(nb2_stack_variant),
+  STACK_VARIANT(nb3_stack_variant),
+  STACK_VARIANT(nb4_stack_variant),
+  STACK_VARIANT(nb5_stack_variant),
+  { "queue", bench_queue_create, bench_queue_destroy, bench_queue_put, bench_queue_get, NULL, NULL },
+  { "ring", bench_ring_create, bench_ring_destroy, bench_ring_put, bench_ring_get, NULL, NULL },
+  { "pqueue", bench_pqueue_create, bench_pqueue_destroy, bench_pqueue_put, bench_pqueue_get, NULL, NULL },
+  { "skiplist", bench_skiplist_create, bench_skiplist_destroy, bench_skiplist_put,
+    bench_skiplist_get, bench_skiplist_find, NULL },
+  { "tree", bench_tree_create, bench_tree_destroy, bench_tree_put, bench_tree_get,
+    bench_tree_find, NULL },
+};
+#define NB_VARIANTS (sizeof(variants) / sizeof(struct variant))
+
+static const char *
+variant_name(const struct variant *variant)
+{
+  return variant->stack != NULL ? variant->stack->name : variant->name;
+}
+
+// Settings of one run, shared by its threads
+struct run
+{
+  const struct variant *variant;
+  void *container;
+  unsigned long lookup_percent;
+  unsigned long push_percent;
+  unsigned long keys;
+  unsigned long think;
+  int pin;
+  volatile int stop;
+  pthread_barrier_t barrier;
+};
+
+struct worker
+{
+  pthread_t thread;
+  int id;
+  struct run *run;
+  unsigned long operations;
+  unsigned long failed;
+} __attribute__((aligned(64)));
+
+static void*
+worker_run(void *arg)
+{
+  struct worker *worker = arg;
+  struct run *run = worker->run;
+  unsigned long operations = 0, failed = 0, spins;
+  unsigned int x = 2654435761u * (worker->id + 1);
+  void *data, *key;
+
+  if (run->pin)
+  {
+    cpu_set_t cpus;
+
+    CPU_ZERO(&cpus);
+    CPU_SET(worker->id % sysconf(_SC_NPROCESSORS_ONLN), &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+  }
+
+  pthread_barrier_wait(&run->barrier);
+
+  while (!run->stop)
+  {
+    // xorshift
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    // Sets see keys from 1 to twice the prefill, so that they stay about
+    // as large as prefilled
+    key = (void*)(size_t)((x >> 8) % run->keys + 1);
+    if ((x >> 24) % 100 < run->lookup_percent)
+      failed += run->variant->find(run->container, key) != 0;
+    else if (x % 100 < run->push_percent)
+      failed += run->variant->put(run->container, key) != 0;
+    else
+      failed += run->variant->get(run->container, key, &data) != 0;
+    operations++;
+
+    for (spins = run->think; spins > 0; spins--)
+      cpu_relax();
+  }
+
+  worker->operations = operations;
+  worker->failed = failed;
+
+  return NULL;
+}
+
+// Throughput in operations per second of one run; fills in the share of
+// failed operations and Jain's fairness index of the threads' progress,
+// which is 1 if all threads did as many operations
+static double
+run_once(const struct variant *variant, int threads, unsigned long lookup_percent,
+    unsigned long push_percent, unsigned long prefill, unsigned long think,
+    int pin, unsigned long duration_ms,
+    double *failed_percent, double *fairness)
+{
+  static struct worker workers[MAX_THREADS];
+  struct timespec start, stop, wait;
+  struct run run;
+  double total = 0, squares = 0, failed = 0, seconds;
+  unsigned long i;
+  int t;
+
+  run.variant = variant;
+  run.container = variant->create(variant, prefill);
+  run.lookup_percent = lookup_percent;
+  run.push_percent = push_percent;
+  run.keys = prefill > 0 ? 2 * prefill : 1;
+  run.think = think;
+  run.pin = pin;
+  run.stop = 0;
+  pthread_barrier_init(&run.barrier, NULL, threads + 1);
+
+  for (i = 0; i < prefill; i++)
+    variant->put(run.container, (void*)(i + 1));
+
+  for (t = 0; t < threads; t++)
+  {
+    workers[t].id = t;
+    workers[t].run = &run;
+    pthread_create(&workers[t].thread, NULL, worker_run, &workers[t]);
+  }
+
+  pthread_barrier_wait(&run.barrier);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  wait.tv_sec = duration_ms / 1000;
+  wait.tv_nsec = (duration_ms % 1000) * 1000000;
+  nanosleep(&wait, NULL);
+  run.stop = 1;
+
+  for (t = 0; t < threads; t++)
+    pthread_join(workers[t].thread, NULL);
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+
+  for (t = 0; t < threads; t++)
+  {
+    total += workers[t].operations;
+    squares += (double)workers[t].operations * workers[t].operations;
+    failed += workers[t].failed;
+  }
+
+  variant->destroy(run.container);
+  pthread_barrier_destroy(&run.barrier);
+
+  seconds = (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) / 1e9;
+  *failed_percent = total > 0 ? 100 * failed / total : 0;
+  *fairness = squares > 0 ? total * total / (threads * squares) : 0;
+
+  return total / seconds;
+}
+
+// Parse a comma-separated list of numbers; returns how many
+static int
+parse_list(const char *arg, unsigned long *values)
+{
+  char *end;
+  int count = 0;
+
+  while (*arg != '\0' && count < MAX_VALUES)
+  {
+    values[count++] = strtoul(arg, &end, 10);
+    if (end == arg || (*end != ',' && *end != '\0'))
+      return -1;
+    arg = *end == ',' ? end + 1 : end;
+  }
+
+  return count;
+}
+
+static int
+variant_selected(const struct variant *variant, const char *list)
+{
+  const char *name = variant_name(variant), *found;
+  size_t length = strlen(name);
+
+  if (list == NULL)
+    return 1;
+
+  for (found = strstr(list, name); found != NULL; found = strstr(found + 1, name))
+    if ((found == list || found[-1] == ',') && (found[length] == ',' || found[length] == '\0'))
+      return 1;
+
+  return 0;
+}
+
+static void
+usage(const char *name)
+{
+  unsigned int i;
+
+  fprintf(stderr, "Usage: %s [-v variants] [-t threads] [-l lookup percents] "
+      "[-r push percents] [-p prefills] [-w think pauses] [-d duration in ms] "
+      "[-n tries] [-a]\n"
+      "Lists are comma-separated; push percents are shares of the operations "
+      "that are not lookups, and only sets run with lookups. -a pins threads "
+      "to processors.\nVariants:",
+      name);
+  for (i = 0; i < NB_VARIANTS; i++)
+    fprintf(stderr, " %s", variant_name(&variants[i]));
+  fprintf(stderr, "\n");
+}
+
+int
+main(int argc, char **argv)
+{
+  unsigned long threads[MAX_VALUES], lookup_percents[MAX_VALUES], push_percents[MAX_VALUES],
+      prefills[MAX_VALUES], thinks[MAX_VALUES], duration_ms, tries, try;
+  int nb_threads, nb_lookup_percents, nb_push_percents, nb_prefills, nb_thinks, pin, opt;
+  int t, l, r, p, w, processors;
+  const char *only = NULL;
+  unsigned int v;
+
+  // Powers of two up to the number of processors, and that number
+  processors = sysconf(_SC_NPROCESSORS_ONLN);
+  for (nb_threads = 0, t = 1; t < processors && nb_threads < MAX_VALUES - 1; t *= 2)
+    threads[nb_threads++] = t;
+  threads[nb_threads++] = processors;
+
+  lookup_percents[0] = DEFAULT_LOOKUP_PERCENT;
+  nb_lookup_percents = 1;
+  push_percents[0] = DEFAULT_PUSH_PERCENT;
+  nb_push_percents = 1;
+  prefills[0] = DEFAULT_PREFILL;
+  nb_prefills = 1;
+  thinks[0] = DEFAULT_THINK;
+  nb_thinks = 1;
+  duration_ms = DEFAULT_DURATION_MS;
+  tries = DEFAULT_TRIES;
+  pin = 0;
+
+  while ((opt = getopt(argc, argv, "v:t:l:r:p:w:d:n:a")) != -1)
+  {
+    switch (opt)
+    {
+    case 'v':
+      only = optarg;
+      break;
+    case 't':
+      nb_threads = parse_list(optarg, threads);
+      break;
+    case 'l':
+      nb_lookup_percents = parse_list(optarg, lookup_percents);
+      break;
+    case 'r':
+      nb_push_percents = parse_list(optarg, push_percents);
+      break;
+    case 'p':
+      nb_prefills = parse_list(optarg, prefills);
+      break;
+    case 'w':
+      nb_thinks = parse_list(optarg, thinks);
+      break;
+    case 'd':
+      duration_ms = strtoul(optarg, NULL, 10);
+      break;
+    case 'n':
+      tries = strtoul(optarg, NULL, 10);
+      break;
+    case 'a':
+      pin = 1;
+      break;
+    default:
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (nb_threads <= 0 || nb_lookup_percents <= 0 || nb_push_percents <= 0
+      || nb_prefills <= 0 || nb_thinks <= 0 || duration_ms == 0 || tries == 0)
+  {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  for (t = 0; t < nb_threads; t++)
+    if (threads[t] < 1 || threads[t] > MAX_THREADS)
+    {
+      fprintf(stderr, "[ERROR] Thread counts must be in [1, %i]\n", MAX_THREADS);
+      return EXIT_FAILURE;
+    }
+  for (l = 0; l < nb_lookup_percents; l++)
+    if (lookup_percents[l] > 100)
+    {
+      fprintf(stderr, "[ERROR] Lookup percents must be in [0, 100]\n");
+      return EXIT_FAILURE;
+    }
+  for (r = 0; r < nb_push_percents; r++)
+    if (push_percents[r] > 100)
+    {
+      fprintf(stderr, "[ERROR] Push percents must be in [0, 100]\n");
+      return EXIT_FAILURE;
+    }
+
+  // Scaling efficiency compares the throughput per thread with the one of
+  // the first thread count of the sweep, usually 1
+  printf("# variant threads lookup_percent push_percent prefill think pinned try ops_per_sec "
+      "failed_percent fairness efficiency\n");
+
+  for (v = 0; v < NB_VARIANTS; v++)
+  {
+    if (!variant_selected(&variants[v], only))
+      continue;
+
+    for (l = 0; l < nb_lookup_percents; l++)
+    {
+      if (lookup_percents[l] > 0 && variants[v].find == NULL)
+        continue;
+
+      for (r = 0; r < nb_push_percents; r++)
+        for (p = 0; p < nb_prefills; p++)
+          for (w = 0; w < nb_thinks; w++)
+            for (try = 1; try <= tries; try++)
+            {
+              double base = 0;
+
+              for (t = 0; t < nb_threads; t++)
+              {
+                double throughput, failed, fairness;
+
+                throughput = run_once(&variants[v], threads[t], lookup_percents[l],
+                    push_percents[r], prefills[p], thinks[w], pin, duration_ms,
+                    &failed, &fairness);
+                if (t == 0)
+                  base = throughput / threads[0];
+
+                printf("%s %lu %lu %lu %lu %lu %i %lu %.0f %.2f %.4f %.3f\n",
+                    variant_name(&variants[v]), threads[t], lookup_percents[l],
+                    push_percents[r], prefills[p], thinks[w], pin, try, throughput,
+                    failed, fairness, base > 0 ? throughput / threads[t] / base : 0);
+              }
+            }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
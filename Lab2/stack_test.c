@@ -33,9 +33,15 @@
 #include <stddef.h>
 
 #include <semaphore.h>
+#include <sched.h>
 
 #include "stack.h"
 #include "non_blocking.h"
+#if RECLAIM == 1
+#include "hazard.h"
+#elif RECLAIM == 2
+#include "epoch.h"
+#endif
 
 #define test_run(test)\
   printf("[%s:%s:%i] Running test '%s'... ", __FILE__, __FUNCTION__, __LINE__, #test);\
@@ -90,6 +96,16 @@ test_setup()
     node->data = &data;
     stack_push(stack, node);
   }
+#elif MEASURE == 3
+  // Fill the stack with enough elements for all pops of the mixed test,
+  // the other half of stack_nodes is pushed by the test
+  for (i = 0; i < MAX_PUSH_POP / 2; i++)
+  {
+    stack_node_t *node = stack_nodes[i];
+    node->data = &data;
+    stack_push(stack, node);
+  }
+  next_node = MAX_PUSH_POP / 2;
 #endif
 }
 
@@ -169,7 +185,7 @@ test_push_safe()
   {
     if (node->data != &data)
       return 0;
-    free(node);
+    stack_node_free(node);
     counter++;
   }
 
@@ -210,6 +226,386 @@ test_pop_safe()
   return stack_pop(stack, NULL) == -1;
 }
 
+static void*
+thread_test_reclaim(void* arg)
+{
+  int i;
+
+  // Nodes are freed as soon as popped while other threads pop too
+  for (i = 0; i < MAX_PUSH_POP; i++)
+    {
+      stack_node_t *node = stack_node_alloc();
+      node->data = &data;
+      if (stack_push(stack, node) != 0)
+        return (void*)-1;
+
+      if (stack_pop(stack, &node) != 0 || node->data != &data)
+        return (void*)-1;
+      node->data = NULL;
+      stack_node_free(node);
+    }
+
+  return (void*)0;
+}
+
+int
+test_reclaim()
+{
+  // Make sure popped nodes can be freed while other threads pop concurrently
+  if (run_test_function(&thread_test_reclaim) != 0)
+    return 0;
+
+  return stack_pop(stack, NULL) == -1;
+}
+
+int
+test_backoff()
+{
+  struct backoff backoff;
+  struct backoff_stats before, after;
+  stack_node_t *node;
+  int i;
+
+  // The waiting limit doubles with every retry up to its cap
+  backoff_init(&backoff);
+  for (i = 0; i < 64; i++)
+    backoff_retry(&backoff);
+#if BACKOFF
+  if (backoff.limit != BACKOFF_MAX)
+    return 0;
+#endif
+  if (backoff.retries != 64)
+    return 0;
+
+  // Uncontended operations succeed at once
+  stack_backoff_stats(&before);
+  node = stack_node_alloc();
+  stack_push(stack, node);
+  stack_pop(stack, &node);
+  stack_node_free(node);
+  stack_backoff_stats(&after);
+
+#if NON_BLOCKING >= 1 && NON_BLOCKING <= 3
+  return after.operations == before.operations + 2 && after.retries == before.retries;
+#else
+  return after.retries == before.retries;
+#endif
+}
+
+#if STACK_STATS
+int
+test_stats()
+{
+  struct stack_op_stats push, pop;
+  stack_node_t *node;
+  int i;
+
+  // Every operation of the calling thread is counted and timed, popping
+  // from the empty stack included
+  stack_stats_reset();
+  for (i = 0; i < 100; i++)
+    stack_push(stack, stack_node_alloc());
+  for (i = 0; i < 101; i++)
+    if (stack_pop(stack, &node) == 0)
+      stack_node_free(node);
+
+  stack_stats(STACK_OP_PUSH, &push);
+  stack_stats(STACK_OP_POP, &pop);
+
+  if (push.operations != 100 || push.latency.count != 100)
+    return 0;
+  if (pop.operations != 101 || pop.latency.count != 101)
+    return 0;
+#if NON_BLOCKING >= 1 && NON_BLOCKING <= 4
+  // Uncontended CAS loops succeed at once
+  if (push.cas_attempts != 100 || push.cas_failures != 0)
+    return 0;
+#endif
+
+  // Percentiles stay within the recorded range
+  return histogram_percentile(&pop.latency, 50) >= pop.latency.min
+      && histogram_percentile(&pop.latency, 99) <= pop.latency.max
+      && histogram_percentile(&pop.latency, 50) <= histogram_percentile(&pop.latency, 99);
+}
+#endif
+
+#define CHAIN_LENGTH 8
+
+static stack_node_t *
+test_make_chain(stack_node_t **last)
+{
+  stack_node_t *first = NULL;
+  int i;
+
+  for (i = 0; i < CHAIN_LENGTH; i++)
+    {
+      stack_node_t *node = stack_node_alloc();
+      node->data = &data;
+      node->prev = first;
+      first = node;
+      if (i == 0)
+        *last = node;
+    }
+
+  return first;
+}
+
+static size_t
+test_free_chain(stack_node_t *node)
+{
+  size_t count = 0;
+
+  while (node != NULL)
+    {
+      stack_node_t *prev = node->prev;
+      if (node->data != &data)
+        return (size_t)-1;
+      stack_node_free(node);
+      node = prev;
+      count++;
+    }
+
+  return count;
+}
+
+static void*
+thread_test_chain(void* arg)
+{
+  int i;
+  size_t popped = 0, count;
+
+  // Push chains and pop as many nodes in batches of various sizes
+  for (i = 0; i < MAX_PUSH_POP / CHAIN_LENGTH; i++)
+    {
+      stack_node_t *first, *last;
+
+      first = test_make_chain(&last);
+      if (stack_push_chain(stack, first, last) != 0)
+        return (void*)-1;
+
+      count = stack_pop_n(stack, 1 + i % (2 * CHAIN_LENGTH), &first);
+      if (test_free_chain(first) != count)
+        return (void*)-1;
+      popped += count;
+    }
+
+  return (void*)popped;
+}
+
+int
+test_chain()
+{
+  pthread_t thread[NB_THREADS];
+  stack_node_t *first, *last;
+  size_t popped = 0, remaining;
+  void *ret;
+  int i;
+
+  // A chain comes out in the order it went in
+  first = test_make_chain(&last);
+  stack_push_chain(stack, first, last);
+  if (stack_pop_n(stack, 3, &last) != 3 || last != first)
+    return 0;
+  if (test_free_chain(last) != 3)
+    return 0;
+  if (stack_pop_all(stack, &first) != 0 || test_free_chain(first) != CHAIN_LENGTH - 3)
+    return 0;
+  if (stack_pop_all(stack, &first) != -1 || stack_pop_n(stack, 1, &first) != 0)
+    return 0;
+
+  // No node is lost or popped twice by concurrent bulk operations
+  for (i = 0; i < NB_THREADS; i++)
+    pthread_create(&thread[i], NULL, &thread_test_chain, NULL);
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      pthread_join(thread[i], &ret);
+      if (ret == (void*)-1)
+        return 0;
+      popped += (size_t)ret;
+    }
+
+  stack_pop_all(stack, &first);
+  remaining = test_free_chain(first);
+
+  return popped + remaining ==
+      (size_t)NB_THREADS * (MAX_PUSH_POP / CHAIN_LENGTH) * CHAIN_LENGTH;
+}
+
+// Nodes handed over to waiting threads
+#define WAIT_NODES (NB_THREADS * 100)
+
+static volatile size_t wait_popped, wait_exited;
+
+static void*
+thread_test_pop_wait(void* arg)
+{
+  stack_node_t *node;
+
+  // Waits forever, so only stack_wake_all() lets threads out
+  while (wait_popped < WAIT_NODES)
+    if (stack_pop_wait(stack, &node, -1) == 0)
+      {
+        stack_node_free(node);
+        __sync_fetch_and_add(&wait_popped, 1);
+      }
+
+  __sync_fetch_and_add(&wait_exited, 1);
+  return NULL;
+}
+
+int
+test_pop_wait()
+{
+  pthread_t thread[NB_THREADS];
+  struct timespec start, stop;
+  stack_node_t *node;
+  long elapsed_us;
+  int i;
+
+  // Waiting on an empty stack times out
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  if (stack_pop_wait(stack, &node, 10000) != -1)
+    return 0;
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+  elapsed_us = (stop.tv_sec - start.tv_sec) * 1000000 + (stop.tv_nsec - start.tv_nsec) / 1000;
+  if (elapsed_us < 10000)
+    return 0;
+
+  // Pushes wake parked threads, which give the processor back between
+  // nodes so that consumers park often
+  wait_popped = 0;
+  wait_exited = 0;
+  for (i = 0; i < NB_THREADS; i++)
+    pthread_create(&thread[i], NULL, &thread_test_pop_wait, NULL);
+  for (i = 0; i < WAIT_NODES; i++)
+    {
+      stack_push(stack, stack_node_alloc());
+      sched_yield();
+    }
+
+  // Then wake the threads still parked, so that they see all is done
+  while (wait_exited < NB_THREADS)
+    {
+      stack_wake_all(stack);
+      sched_yield();
+    }
+  for (i = 0; i < NB_THREADS; i++)
+    pthread_join(thread[i], NULL);
+
+  return wait_popped == WAIT_NODES && stack_pop(stack, NULL) == -1;
+}
+
+#if RECLAIM != 0
+static int released;
+
+static void
+count_release(void *ptr)
+{
+  released++;
+}
+#endif
+
+#if RECLAIM == 1
+int
+test_hazard()
+{
+  static int a, b;
+
+  // A retired pointer is released only once no hazard slot protects it
+  released = 0;
+  hazard_protect(0, &a);
+  hazard_retire(&a, count_release);
+  hazard_retire(&b, count_release);
+
+  if (hazard_scan() != 1 || released != 1)
+    return 0;
+
+  hazard_clear(0);
+
+  return hazard_scan() == 0 && released == 2;
+}
+#elif RECLAIM == 2
+static sem_t epoch_entered, epoch_leave;
+
+static void*
+thread_test_epoch(void* arg)
+{
+  epoch_enter();
+  sem_post(&epoch_entered);
+  sem_wait(&epoch_leave);
+  epoch_exit();
+
+  return (void*)0;
+}
+
+int
+test_epoch()
+{
+  static int a, b;
+  pthread_t thread;
+  int i;
+
+  // A retired pointer is released only once no thread that may hold it is
+  // in a critical section anymore
+  if (epoch_collect() != 0)
+    return 0;
+  released = 0;
+  sem_init(&epoch_entered, 0, 0);
+  sem_init(&epoch_leave, 0, 0);
+  pthread_create(&thread, NULL, thread_test_epoch, NULL);
+  sem_wait(&epoch_entered);
+
+  epoch_retire(&a, epoch_birth(), count_release);
+  for (i = 0; i < 4; i++)
+    epoch_collect();
+  if (released != 0)
+    return 0;
+
+  // Pointers allocated after the thread stalled cannot be held by it, so
+  // retiring many more of them must neither wait for it nor pile up
+  for (i = 0; i < 1 << 18; i++)
+  {
+    epoch_retire(&b, epoch_birth(), count_release);
+    if (i + 2 - released > 2 * EPOCH_ADVANCE_PERIOD)
+      return 0;
+  }
+  if (epoch_collect() != 1 || released != 1 << 18)
+    return 0;
+
+  sem_post(&epoch_leave);
+  pthread_join(thread, NULL);
+
+  return epoch_collect() == 0 && released == (1 << 18) + 1;
+}
+#endif
+
+#if NODE_POOL && RECLAIM == 0
+int
+test_pool()
+{
+  struct pool_stats before, after;
+  stack_node_t *nodes[4 * POOL_BATCH];
+  int i;
+
+  // Freed nodes must be reused, and whole batches must go back to the
+  // global list once a thread caches too many of them
+  stack_node_pool_stats(&before);
+  for (i = 0; i < 4 * POOL_BATCH; i++)
+    nodes[i] = stack_node_alloc();
+  for (i = 0; i < 4 * POOL_BATCH; i++)
+    stack_node_free(nodes[i]);
+  for (i = 0; i < 4 * POOL_BATCH; i++)
+    nodes[i] = stack_node_alloc();
+  stack_node_pool_stats(&after);
+
+  for (i = 0; i < 4 * POOL_BATCH; i++)
+    stack_node_free(nodes[i]);
+
+  return after.returns > before.returns && after.refills > before.refills &&
+      after.slabs - before.slabs <= 4;
+}
+#endif
+
 pthread_barrier_t aba_barrier;
 sem_t aba_read_a_sem, aba_reinsert_a_sem; 
 
@@ -318,11 +714,20 @@ test_aba()
   if (stack_pop(stack, &node) != 0)
     return 0;
 
+#if NON_BLOCKING == 3
+  // Tagged pointers must prevent it
+  if (node == C) {
+    printf("The head of the stack is C after the sequence: \n"
+           " pop -> pop -> push A -> pop.\n");
+    res = 1;
+  }
+#else
   if (node == B) {
     printf("The head of the stack is B although it should be C after the sequence: \n"
            " pop -> pop -> push A -> pop.\n");
     res = 1;
   }
+#endif
 
   return res;
 }
@@ -415,6 +820,90 @@ test_cas()
 #endif
 }
 
+#define CASN_ACCOUNTS 8
+
+static size_t casn_counter;
+static size_t casn_accounts[CASN_ACCOUNTS];
+
+static void*
+thread_test_software_cas(void* arg)
+{
+  thread_test_cas_args_t *args = (thread_test_cas_args_t*) arg;
+  size_t *regs[2], old[2], new[2], from, to;
+  unsigned int x = 2654435761u * (args->id + 1);
+  int i;
+
+  for (i = 0; i < MAX_PUSH_POP; i++)
+    {
+      do {
+        old[0] = casn_counter;
+      } while (software_cas(&casn_counter, old[0], old[0] + 1) != old[0]);
+
+      // Move one unit between two random accounts; their sum never changes
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      from = x % CASN_ACCOUNTS;
+      to = (x / CASN_ACCOUNTS) % CASN_ACCOUNTS;
+      if (from == to)
+        continue;
+
+      regs[0] = &casn_accounts[from];
+      regs[1] = &casn_accounts[to];
+      do {
+        old[0] = casn_accounts[from];
+        old[1] = casn_accounts[to];
+        new[0] = old[0] - 1;
+        new[1] = old[1] + 1;
+      } while (!software_casn(2, regs, old, new));
+    }
+
+  return NULL;
+}
+
+int
+test_software_cas()
+{
+  pthread_t thread[NB_THREADS];
+  thread_test_cas_args_t args[NB_THREADS];
+  size_t sum = 0;
+  int i;
+
+  // Single-word software CAS counts like the hardware one, and CASN keeps
+  // invariants spanning several words
+  casn_counter = 0;
+  for (i = 0; i < CASN_ACCOUNTS; i++)
+    casn_accounts[i] = NB_THREADS * MAX_PUSH_POP;
+
+  for (i = 0; i < NB_THREADS; i++)
+    {
+      args[i].id = i;
+      pthread_create(&thread[i], NULL, &thread_test_software_cas, &args[i]);
+    }
+  for (i = 0; i < NB_THREADS; i++)
+    pthread_join(thread[i], NULL);
+
+  for (i = 0; i < CASN_ACCOUNTS; i++)
+    sum += casn_accounts[i];
+
+  return casn_counter == (size_t)(NB_THREADS * MAX_PUSH_POP)
+      && sum == (size_t)(CASN_ACCOUNTS * NB_THREADS * MAX_PUSH_POP);
+}
+
+int
+test_casn()
+{
+  size_t words[3] = { 1, 2, 3 }, *regs[3] = { &words[0], &words[1], &words[2] };
+  size_t old[3] = { 1, 2, 3 }, new[3] = { 4, 5, 6 }, stale[3] = { 1, 0, 3 };
+
+  // Nothing is written if any word differs, everything otherwise
+  if (software_casn(3, regs, stale, new) || words[0] != 1 || words[2] != 3)
+    return 0;
+
+  return software_casn(3, regs, old, new) && words[0] == 4 && words[1] == 5
+      && words[2] == 6;
+}
+
 // Stack performance test
 #if MEASURE != 0
 struct stack_measure_arg
@@ -461,6 +950,32 @@ thread_test_performance_pop(void* data)
   clock_gettime(CLOCK_MONOTONIC, &t_stop[arg->id]);
   return (void*)0; 
 }
+#elif MEASURE == 3
+static void*
+thread_test_performance_mixed(void* data)
+{
+  stack_measure_arg_t* arg = (stack_measure_arg_t*)data;
+  int i;
+
+  // Alternate push and pop, so that pairs can cancel out
+  for (i = 0; i < MAX_PUSH_POP/NB_THREADS; i++)
+    {
+      stack_node_t *node;
+      if (i % 2 == 0)
+        {
+          int node_index = __sync_fetch_and_add(&next_node, 1);
+          node = stack_nodes[node_index];
+          node->data = &data;
+          if (stack_push(stack, node) != 0)
+            return (void*)-1;
+        }
+      else if (stack_pop(stack, &node) != 0)
+        return (void*)-1;
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &t_stop[arg->id]);
+  return (void*)0; 
+}
 #endif
 
 #endif
@@ -474,9 +989,26 @@ setbuf(stdout, NULL);
   test_init();
 
   test_run(test_cas);
+  test_run(test_software_cas);
+  test_run(test_casn);
 
   test_run(test_push_safe);
   test_run(test_pop_safe);
+  test_run(test_reclaim);
+  test_run(test_chain);
+  test_run(test_pop_wait);
+  test_run(test_backoff);
+#if STACK_STATS
+  test_run(test_stats);
+#endif
+#if NODE_POOL && RECLAIM == 0
+  test_run(test_pool);
+#endif
+#if RECLAIM == 1
+  test_run(test_hazard);
+#elif RECLAIM == 2
+  test_run(test_epoch);
+#endif
   test_run(test_aba);
 
   test_finalize();
@@ -488,6 +1020,10 @@ setbuf(stdout, NULL);
   pthread_t thread[NB_THREADS];
 
   test_setup();
+#if STACK_STATS
+  // Leave out the nodes pushed to fill the stack
+  stack_stats_reset();
+#endif
 
   pthread_attr_init(&attr);
   pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE); 
@@ -502,6 +1038,10 @@ setbuf(stdout, NULL);
       clock_gettime(CLOCK_MONOTONIC, &t_start[i]);
       // Push MAX_PUSH_POP times in parallel
       pthread_create(&thread[i], &attr, &thread_test_performance_push, &arg[i]);
+#elif MEASURE == 3
+      clock_gettime(CLOCK_MONOTONIC, &t_start[i]);
+      // Push and pop MAX_PUSH_POP times in total in parallel
+      pthread_create(&thread[i], &attr, &thread_test_performance_mixed, &arg[i]);
 #else
       // Run pop-based performance test based on MEASURE token
 
@@ -527,6 +1067,11 @@ setbuf(stdout, NULL);
           (int) t_start[i].tv_sec, t_start[i].tv_nsec, (int) t_stop[i].tv_sec,
           t_stop[i].tv_nsec);
     }
+
+#if STACK_STATS
+  // Kept apart from the timings read by the experiment scripts
+  stack_stats_dump(stderr);
+#endif
 #endif
 
   return 0;
@@ -23,10 +23,15 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <assert.h>
 #include <string.h>
 #include <pthread.h>
 #include <semaphore.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "disable.h"
 #include "array.h"
@@ -76,6 +81,9 @@ array_prealloc()
 
     array->length = 0;
     array->capacity = 0;
+    array->data = NULL;
+    array->map = NULL;
+    array->map_size = 0;
 
     return array;
   }
@@ -98,7 +106,7 @@ array_alloc(int size)
   }
 
 struct array*
-array_read(char * filename)
+array_read_ascii(char * filename)
 {
   int i;
   FILE * h;
@@ -107,6 +115,12 @@ array_read(char * filename)
   struct array * res;
 
   h = fopen(filename, "r");
+  if (h == NULL)
+    {
+      perror(filename);
+      return NULL;
+    }
+
   i = read_value(h, &num);
   assert(i > 0);
   
@@ -124,6 +138,68 @@ array_read(char * filename)
   return res;
 }
 
+struct array*
+array_read(char * filename)
+{
+  int fd;
+  struct stat st;
+  struct array_header header;
+  uint64_t length;
+  void *map;
+  struct array * res;
+
+  fd = open(filename, O_RDONLY);
+  if (fd < 0)
+    {
+      perror(filename);
+      return NULL;
+    }
+
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(header)
+      || read(fd, &header, sizeof(header)) != sizeof(header)
+      || memcmp(header.magic, ARRAY_MAGIC, sizeof(header.magic)) != 0)
+    {
+      close(fd);
+      return array_read_ascii(filename);
+    }
+
+  length = ARRAY_LE64(header.length);
+  if (ARRAY_LE32(header.version) != ARRAY_VERSION || length > INT_MAX
+      || (size_t)st.st_size < sizeof(header) + length * sizeof(value))
+    {
+      fprintf(stderr, "[ERROR] %s: unsupported version or truncated file\n", filename);
+      close(fd);
+      return NULL;
+    }
+
+  // Private mapping: sorting in place copies only the pages it writes to and
+  // leaves the file untouched
+  map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    {
+      perror(filename);
+      return NULL;
+    }
+
+  res = array_prealloc();
+  res->map = map;
+  res->map_size = st.st_size;
+  res->data = (value*)((char*)map + sizeof(header));
+  res->length = res->capacity = length;
+
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  {
+    int i;
+
+    for (i = 0; i < res->length; i++)
+      res->data[i] = ARRAY_LE32(res->data[i]);
+  }
+#endif
+
+  return res;
+}
+
 #if 0
 static int
 min(int a, int b)
@@ -153,21 +229,71 @@ array_printf(struct array* a)
   sem_post(&sem_printf);
 }
 
+static int
+write_values(FILE * h, value * data, size_t n)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  uint32_t buffer[4096];
+  size_t i, chunk;
+
+  for (; n > 0; n -= chunk, data += chunk)
+    {
+      chunk = n < 4096 ? n : 4096;
+      for (i = 0; i < chunk; i++)
+        buffer[i] = ARRAY_LE32(data[i]);
+      if (fwrite(buffer, sizeof(uint32_t), chunk, h) != chunk)
+        return -1;
+    }
+
+  return 0;
+#else
+  // A single large write, which stdio passes through without buffering
+  return fwrite(data, sizeof(value), n, h) == n ? 0 : -1;
+#endif
+}
+
 int
-array_write(struct array* a, char* filename)
+array_fwrite(struct array* a, FILE * h, enum array_format format)
 {
   int i;
+  struct array_header header = { ARRAY_MAGIC, ARRAY_LE32(ARRAY_VERSION),
+      ARRAY_LE64((uint64_t)a->length) };
+
+  if (format == ARRAY_ASCII)
+    {
+      fprintf(h, "%i ", a->length);
+      for (i = 0; i < a->length; i++)
+        {
+          fprintf(h, "%i ", a->data[i]);
+        }
+
+      return ferror(h) ? -1 : 0;
+    }
+
+  if (fwrite(&header, sizeof(header), 1, h) != 1)
+    return -1;
+
+  return write_values(h, a->data, a->length);
+}
+
+int
+array_write(struct array* a, char* filename)
+{
+  int res;
   FILE * h;
 
   h = fopen(filename, "w");
-
-  fprintf(h, "%i ", a->length);
-  for (i = 0; i < a->length; i++)
+  if (h == NULL)
     {
-      fprintf(h, "%i ", a->data[i]);
+      perror(filename);
+      return -1;
     }
 
-  return -1;
+  res = array_fwrite(a, h, ARRAY_BINARY);
+  if (fclose(h) != 0)
+    res = -1;
+
+  return res;
 }
 
 #if 0
@@ -222,7 +348,12 @@ array_prefree(struct array* array)
 void
 array_free(struct array* array)
 {
-  free(array->data);
+  // Sorts may have swapped the mapped data for a buffer of their own
+  if (array->map == NULL
+      || array->data != (value*)((char*)array->map + sizeof(struct array_header)))
+    free(array->data);
+  if (array->map != NULL)
+    munmap(array->map, array->map_size);
   array_prefree(array);
 }
 
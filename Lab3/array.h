@@ -28,6 +28,9 @@
 #ifndef ARRAY_H_
 #define ARRAY_H_
 
+#include <stdio.h>
+#include <stdint.h>
+
 typedef int value;
 
 struct array
@@ -35,15 +38,49 @@ struct array
   int length;
   int capacity;
   value* data;
+  // File data points into when read from a binary file, or NULL
+  void* map;
+  size_t map_size;
+};
+
+// Binary array files start with this header, followed by the values as
+// little-endian 32-bit integers. All header fields are little-endian, too.
+#define ARRAY_MAGIC "TDDA"
+#define ARRAY_VERSION 1
+
+struct array_header
+{
+  char magic[4];
+  uint32_t version;
+  uint64_t length;
+};
+
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define ARRAY_LE32(x) __builtin_bswap32(x)
+#define ARRAY_LE64(x) __builtin_bswap64(x)
+#else
+#define ARRAY_LE32(x) (x)
+#define ARRAY_LE64(x) (x)
+#endif
+
+enum array_format
+{
+  ARRAY_BINARY, ARRAY_ASCII
 };
 
 void array_init(int, char **);
 
+// Read a binary file, mapped in memory without copy, or an ASCII file
 struct array * array_read(char *);
+// Legacy format: the number of values then the values, in decimal and
+// separated by spaces
+struct array * array_read_ascii(char *);
 void array_printf(struct array*);
 struct array * array_alloc(int);
 void array_free(struct array*);
+// Write in binary format. Return 0 on success, -1 on error.
 int array_write(struct array*, char*);
+int array_fwrite(struct array*, FILE*, enum array_format);
 int array_check_ascending(struct array*);
 int array_trycheck_ascending(struct array*);
 
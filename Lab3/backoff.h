@@ -0,0 +1,122 @@
+/*
+ * backoff.h
+ *
+ *  Created on: 19 Oct 2026
+ *
+ * This file is part of TDDD56.
+ *
+ *     TDDD56 is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     TDDD56 is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with TDDD56. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <stddef.h>
+
+#ifndef BACKOFF_H_
+#define BACKOFF_H_
+
+// Backoff for CAS retry loops: after each failed attempt, wait a random
+// number of pause instructions below a limit that doubles up to a cap, so
+// that contending threads spread out instead of fighting for the same
+// cache line. BACKOFF=0 retries at once but keeps counting retries.
+
+#ifndef BACKOFF
+#define BACKOFF 1
+#endif
+// Limits of the waiting time, in pause instructions
+#ifndef BACKOFF_MIN
+#define BACKOFF_MIN 4
+#endif
+#ifndef BACKOFF_MAX
+#define BACKOFF_MAX 1024
+#endif
+
+struct backoff
+{
+  unsigned int limit;
+  unsigned int seed;
+  unsigned int retries;
+  unsigned long spins;
+};
+
+struct backoff_stats
+{
+  unsigned long operations;
+  unsigned long retries;
+  unsigned long max_retries;  // retries of the unluckiest operation
+  unsigned long spins;        // pause instructions waited
+};
+
+static inline void
+cpu_relax(void)
+{
+#if defined __x86_64__ || defined __i386__
+  __asm__ __volatile__("pause" ::: "memory");
+#elif defined __aarch64__ || defined __arm__
+  __asm__ __volatile__("yield" ::: "memory");
+#else
+  __asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+static inline void
+backoff_init(struct backoff *backoff)
+{
+  backoff->limit = BACKOFF_MIN;
+  // Threads have their loop state at different addresses
+  backoff->seed = (unsigned int)(size_t)backoff | 1;
+  backoff->retries = 0;
+  backoff->spins = 0;
+}
+
+// Wait before the next attempt. Always returns 1, so that it can end the
+// condition of a retry loop: while (cas(...) != old && backoff_retry(&b));
+static inline int
+backoff_retry(struct backoff *backoff)
+{
+#if BACKOFF
+  unsigned int x = backoff->seed, spins;
+
+  // xorshift
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  backoff->seed = x;
+
+  // Jitter over the whole range, so that threads failing together do not
+  // retry together
+  spins = x % backoff->limit + 1;
+  backoff->spins += spins;
+  for (; spins > 0; spins--)
+    cpu_relax();
+
+  if (backoff->limit < BACKOFF_MAX)
+    backoff->limit *= 2;
+#endif
+  backoff->retries++;
+
+  return 1;
+}
+
+static inline void
+backoff_account(struct backoff_stats *stats, const struct backoff *backoff)
+{
+  stats->operations++;
+  stats->retries += backoff->retries;
+  stats->spins += backoff->spins;
+  if (backoff->retries > stats->max_retries)
+    stats->max_retries = backoff->retries;
+}
+
+#endif /* BACKOFF_H_ */
@@ -23,15 +23,20 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+
+#include "array.h"
 
 int
 main(int argc, char ** argv)
 {
-	int i, min, count;
+	int i, min, count, chunk;
+	struct array_header header;
+	uint32_t buffer[4096];
 
 	if(argc < 4)
 	{
-		printf("Usage: %s <min_value> <max_value> <number of values>\n", argv[0]);
+		printf("Usage: %s <min_value> <max_value> <number of values> [binary|ascii]\n", argv[0]);
 		return EXIT_FAILURE;
 	}
 	else
@@ -39,10 +44,34 @@ main(int argc, char ** argv)
 		min = atoi(argv[1]);
 		count = atoi(argv[3]);
 
-		printf("%d ", count);
-		for(i = 0; i < count; i++)
+		if(argc > 4 && strcmp(argv[4], "ascii") == 0)
+		{
+			printf("%d ", count);
+			for(i = 0; i < count; i++)
+			{
+				printf("%d ", min);
+			}
+			return 0;
+		}
+
+		// Not linked with array.o, so write the binary format by hand
+		memcpy(header.magic, ARRAY_MAGIC, sizeof(header.magic));
+		header.version = ARRAY_LE32(ARRAY_VERSION);
+		header.length = ARRAY_LE64((uint64_t)count);
+		for(i = 0; i < 4096; i++)
+		{
+			buffer[i] = ARRAY_LE32(min);
+		}
+
+		fwrite(&header, sizeof(header), 1, stdout);
+		for(i = 0; i < count; i += chunk)
 		{
-			printf("%d ", min);
+			chunk = count - i < 4096 ? count - i : 4096;
+			if(fwrite(buffer, sizeof(uint32_t), chunk, stdout) != chunk)
+			{
+				perror(argv[0]);
+				return EXIT_FAILURE;
+			}
 		}
 	}
 	
@@ -31,6 +31,15 @@ merge_task_init(task_t* task, int id,
   task->merge.to = to;
 }
 
+// Retries of the CAS loops of the calling thread
+static __thread struct backoff_stats backoff_stats;
+
+void
+task_stack_backoff_stats(struct backoff_stats *stats)
+{
+  *stats = backoff_stats;
+}
+
 struct task_stack_node
 {
   task_t task;
@@ -49,6 +58,7 @@ task_stack_init(task_stack_t *stack, unsigned int size)
   stack->next_node = 0;
 
   stack->head = NULL;
+  park_init(&stack->park);
 
   return 0;
 }
@@ -82,6 +92,7 @@ void
 task_stack_push(task_stack_t *stack, task_t* task)
 {
   task_stack_node_t *node, *head;
+  struct backoff backoff;
 
   assert(stack != NULL);
   assert(task != NULL);
@@ -90,10 +101,15 @@ task_stack_push(task_stack_t *stack, task_t* task)
    * it to a task_node_t. */
   node = (task_stack_node_t*)task;
 
+  backoff_init(&backoff);
   do {
     head = stack->head;
     node->prev = head;
-  } while (cas((size_t*)&stack->head, (size_t)head, (size_t)node) != (size_t)head);
+  } while (cas((size_t*)&stack->head, (size_t)head, (size_t)node) != (size_t)head &&
+      backoff_retry(&backoff));
+  backoff_account(&backoff_stats, &backoff);
+
+  park_wake_one(&stack->park);
 }
 
 int
@@ -101,13 +117,17 @@ task_stack_pop(task_stack_t* stack, task_t** task)
 {
   task_stack_node_t* popped = NULL;
   task_stack_node_t* new_head;
+  struct backoff backoff;
 
   assert(stack != NULL);
 
+  backoff_init(&backoff);
   do {
     popped = stack->head;
     new_head = popped != NULL ? popped->prev : NULL;
-  } while (cas((size_t*)&stack->head, (size_t)popped, (size_t)new_head) != (size_t)popped);
+  } while (cas((size_t*)&stack->head, (size_t)popped, (size_t)new_head) != (size_t)popped &&
+      backoff_retry(&backoff));
+  backoff_account(&backoff_stats, &backoff);
 
   if (popped == NULL)
     return -1;
@@ -117,3 +137,48 @@ task_stack_pop(task_stack_t* stack, task_t** task)
 
   return 0;
 }
+
+// Attempts of task_stack_pop_wait() before parking
+#define TASK_WAIT_SPINS 128
+
+int
+task_stack_pop_wait(task_stack_t* stack, task_t** task, long timeout_us)
+{
+  struct timespec deadline;
+  int i, ticket, interrupts;
+
+  interrupts = park_interrupts(&stack->park);
+
+  for (i = 0; i < TASK_WAIT_SPINS; i++)
+  {
+    if (task_stack_pop(stack, task) == 0)
+      return 0;
+    cpu_relax();
+  }
+
+  // Wait again after spurious wakeups or tasks taken by others, until the
+  // one deadline
+  park_deadline(&deadline, timeout_us);
+  for (;;)
+  {
+    ticket = park_prepare(&stack->park);
+    if (task_stack_pop(stack, task) == 0)
+    {
+      park_cancel(&stack->park);
+      return 0;
+    }
+    if (park_interrupts(&stack->park) != interrupts)
+    {
+      park_cancel(&stack->park);
+      return 1;
+    }
+    if (park_wait(&stack->park, ticket, &deadline) != 0)
+      return task_stack_pop(stack, task) == 0 ? 0 : -1;
+  }
+}
+
+void
+task_stack_wake_all(task_stack_t* stack)
+{
+  park_interrupt(&stack->park);
+}
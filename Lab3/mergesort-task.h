@@ -1,6 +1,9 @@
 
 #include <stdlib.h>
 
+#include "backoff.h"
+#include "park.h"
+
 #ifndef TASK_H
 #define TASK_H
 
@@ -41,6 +44,8 @@ struct task_stack
   volatile unsigned int next_node;
 
   task_stack_node_t *head;
+  // Workers waiting for tasks
+  struct park park;
 };
 typedef struct task_stack task_stack_t;
 
@@ -51,6 +56,14 @@ task_t*   task_stack_reserve(task_stack_t* stack);
 
 void      task_stack_push(task_stack_t* stack, task_t* task);
 int       task_stack_pop(task_stack_t* stack, task_t** task);
+// Pop, sleeping up to timeout_us microseconds until a task is pushed.
+// Returns 0 with a task, -1 if none came in time, or 1 if
+// task_stack_wake_all() was called since this call began.
+int       task_stack_pop_wait(task_stack_t* stack, task_t** task, long timeout_us);
+void      task_stack_wake_all(task_stack_t* stack);
+
+// Operations and retries in CAS loops of the calling thread so far
+void      task_stack_backoff_stats(struct backoff_stats *stats);
 
 
 #endif /* TASK_H */
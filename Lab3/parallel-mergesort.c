@@ -8,6 +8,9 @@
 #include "quicksort.h"
 
 #define SEQUENTIAL_SORT_SIZE 2000000
+// Longest sleep of an idle worker; workers are woken at once when tasks
+// are pushed or all work is done, this only bounds missed wake-ups
+#define TASK_WAIT_US 1000
 
 #define MIN(x, y) ((x) < (y) ? (x) : (y))
 #define MAX(x, y) ((x) > (y) ? (x) : (y))
@@ -129,7 +132,8 @@ merge_task(task_t* task)
 
   /* Finished */
   if (task->id == 0) {
-    __sync_add_and_fetch(&finished_counter, -1);
+    if (__sync_add_and_fetch(&finished_counter, -1) == 0)
+      task_stack_wake_all(&task_stack);
     return;
   }
 
@@ -164,14 +168,8 @@ thread_func(void* data)
     task_t *task;
 
     /* Pull task */
-    if (task_stack_pop(&task_stack, &task) != 0) {
-      if (finished_counter == 0)
-        break;
-
-      /* Sleep a little while */
-      usleep(10);
+    if (task_stack_pop_wait(&task_stack, &task, TASK_WAIT_US) != 0)
       continue;
-    }
 
     switch (task->type) {
       case TASK_TYPE_SORT:
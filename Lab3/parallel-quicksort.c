@@ -10,6 +10,9 @@
 #include "quicksort.h"
 
 #define SEQUENTIAL_SORT_SIZE 20000
+// Longest sleep of an idle worker; workers are woken at once when tasks
+// are pushed or all work is done, this only bounds missed wake-ups
+#define TASK_WAIT_US 1000
 
 int* array;
 unsigned volatile int task_counter;
@@ -103,8 +106,10 @@ sequential_partition(task_t* task) {
   else if (task->partition.right_neutralized == task->partition.blocks)
     return task->partition.start;
   
-  // Sequential partitioning
-  int* blocks = task->partition.remaining_blocks;
+  // Sequential partitioning, on a packed copy of the blocks left over
+  int blocks[NB_THREADS];
+  for (i = 0; i < NB_THREADS; i++)
+    blocks[i] = task->partition.remaining_blocks[i].index;
   quicksort(blocks, 0, NB_THREADS - 1);
 
   // Try to neutralize the remaining blocks
@@ -208,9 +213,9 @@ parallel_partition(task_t* task, int tid) {
   }
 
   if (left_block.index >= 0)
-    task->partition.remaining_blocks[tid] = left_block.index;
+    task->partition.remaining_blocks[tid].index = left_block.index;
   else
-    task->partition.remaining_blocks[tid] = right_block.index;
+    task->partition.remaining_blocks[tid].index = right_block.index;
 
   __sync_fetch_and_add(&task->partition.left_neutralized, left_counter);
   __sync_fetch_and_add(&task->partition.right_neutralized, right_counter);
@@ -296,8 +301,9 @@ sort_task(task_t* task)
   // Sort
   quicksort(array, task->sort.start, task->sort.end);
 
-  // Finished one task
-  __sync_fetch_and_add(&task_counter, -1);
+  // Finished one task; the last one releases the waiting workers
+  if (__sync_add_and_fetch(&task_counter, -1) == 0)
+    task_stack_wake_all(&task_stack);
 }
 
 static void*
@@ -310,10 +316,8 @@ thread_func(void* data)
     task_t *task;
 
     /* Pull task */
-    if (task_stack_pop(&task_stack, &task) != 0) {
-      usleep(50);
+    if (task_stack_pop_wait(&task_stack, &task, TASK_WAIT_US) != 0)
       continue;
-    }
 
     switch (task->type) {
       case TASK_TYPE_PARTITION:
@@ -27,7 +27,7 @@ partition_task_init(task_t* task,
   task->partition.next_blocks = TO_NEXT_BLOCKS(0, task->partition.blocks - 1);
 
   for (i = 0; i < NB_THREADS; i++)
-    task->partition.remaining_blocks[i] = -1;
+    task->partition.remaining_blocks[i].index = -1;
 
   task->partition.left_neutralized = 0;
   task->partition.right_neutralized = 0;
@@ -97,6 +97,15 @@ sort_task_init(task_t* task,
   task->sort.end = end;
 }
 
+// Retries of the CAS loops of the calling thread
+static __thread struct backoff_stats backoff_stats;
+
+void
+task_stack_backoff_stats(struct backoff_stats *stats)
+{
+  *stats = backoff_stats;
+}
+
 struct task_stack_node
 {
   task_t task;
@@ -109,12 +118,13 @@ task_stack_init(task_stack_t *stack, unsigned int size)
   assert(stack != NULL);
 
   stack->size = size;
-  stack->nodes = malloc(size*sizeof(task_stack_node_t));
-  if (stack->nodes == NULL)
+  // Tasks are cache-line aligned, which malloc() does not guarantee
+  if (posix_memalign((void**)&stack->nodes, CACHE_LINE_SIZE, size*sizeof(task_stack_node_t)) != 0)
     return ENOMEM;
   stack->next_node = 0;
 
   stack->head = NULL;
+  park_init(&stack->park);
 
   return 0;
 }
@@ -148,6 +158,7 @@ void
 task_stack_push(task_stack_t *stack, task_t* task)
 {
   task_stack_node_t *node, *head;
+  struct backoff backoff;
 
   assert(stack != NULL);
   assert(task != NULL);
@@ -156,10 +167,15 @@ task_stack_push(task_stack_t *stack, task_t* task)
    * it to a task_node_t. */
   node = (task_stack_node_t*)task;
 
+  backoff_init(&backoff);
   do {
     head = stack->head;
     node->prev = head;
-  } while (__sync_val_compare_and_swap(&stack->head, head, node) != head);
+  } while (__sync_val_compare_and_swap(&stack->head, head, node) != head &&
+      backoff_retry(&backoff));
+  backoff_account(&backoff_stats, &backoff);
+
+  park_wake_one(&stack->park);
 }
 
 int
@@ -167,9 +183,11 @@ task_stack_pop(task_stack_t* stack, task_t** task)
 {
   task_stack_node_t* popped = NULL;
   task_stack_node_t* new_head;
+  struct backoff backoff;
 
   assert(stack != NULL);
 
+  backoff_init(&backoff);
   do {
     task_t* t;
 
@@ -185,7 +203,9 @@ task_stack_pop(task_stack_t* stack, task_t** task)
       break;
 
     new_head = popped->prev;
-  } while (__sync_val_compare_and_swap(&stack->head, popped, new_head) != popped);
+  } while (__sync_val_compare_and_swap(&stack->head, popped, new_head) != popped &&
+      backoff_retry(&backoff));
+  backoff_account(&backoff_stats, &backoff);
 
   if (popped == NULL)
     return -1;
@@ -195,3 +215,48 @@ task_stack_pop(task_stack_t* stack, task_t** task)
 
   return 0;
 }
+
+// Attempts of task_stack_pop_wait() before parking
+#define TASK_WAIT_SPINS 128
+
+int
+task_stack_pop_wait(task_stack_t* stack, task_t** task, long timeout_us)
+{
+  struct timespec deadline;
+  int i, ticket, interrupts;
+
+  interrupts = park_interrupts(&stack->park);
+
+  for (i = 0; i < TASK_WAIT_SPINS; i++)
+  {
+    if (task_stack_pop(stack, task) == 0)
+      return 0;
+    cpu_relax();
+  }
+
+  // Wait again after spurious wakeups or tasks taken by others, until the
+  // one deadline
+  park_deadline(&deadline, timeout_us);
+  for (;;)
+  {
+    ticket = park_prepare(&stack->park);
+    if (task_stack_pop(stack, task) == 0)
+    {
+      park_cancel(&stack->park);
+      return 0;
+    }
+    if (park_interrupts(&stack->park) != interrupts)
+    {
+      park_cancel(&stack->park);
+      return 1;
+    }
+    if (park_wait(&stack->park, ticket, &deadline) != 0)
+      return task_stack_pop(stack, task) == 0 ? 0 : -1;
+  }
+}
+
+void
+task_stack_wake_all(task_stack_t* stack)
+{
+  park_interrupt(&stack->park);
+}
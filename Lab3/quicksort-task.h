@@ -2,11 +2,29 @@
 #include <stdbool.h>
 #include <stdlib.h>
 
+#include "backoff.h"
+#include "park.h"
+
 #ifndef TASK_H
 #define TASK_H
 
 #define BLOCK_SIZE 2048
 
+// Fields written by different threads sit on cache lines of their own. Use
+// 128 on processors whose prefetcher fetches lines in pairs, and
+// PADDING=0 to pack them together for comparisons.
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+#endif
+#ifndef PADDING
+#define PADDING 1
+#endif
+#if PADDING
+#define PADDED __attribute__((aligned(CACHE_LINE_SIZE)))
+#else
+#define PADDED
+#endif
+
 #define MIN(x, y) ((x) < (y) ? (x) : (y))
 #define MAX(x, y) ((x) > (y) ? (x) : (y))
 
@@ -32,25 +50,38 @@ typedef struct
   unsigned int end;
 } block_t;
 
+// Block index left over by one helper, on a cache line of its own so that
+// helpers do not write to each other's lines
+typedef struct
+{
+  int index;
+} PADDED remaining_block_t;
+
 typedef struct
 {
   task_type_t type;
   union {
     struct 
     {
+      // Set by the owner, read by every helper and by idle workers
       volatile partition_state_t state;
-      volatile unsigned int busy_threads;
 
       unsigned int start;
       unsigned int end;
 
       unsigned int blocks;
-      size_t next_blocks;
 
       int pivot;
-      int remaining_blocks[NB_THREADS];
-      volatile unsigned int left_neutralized;
+
+      // Claimed block by block by every helper
+      size_t next_blocks PADDED;
+      // Counted up and down by every helper, polled by the owner
+      volatile unsigned int busy_threads PADDED;
+      // Added to by every helper when done
+      volatile unsigned int left_neutralized PADDED;
       volatile unsigned int right_neutralized;
+      // Written once by each helper
+      remaining_block_t remaining_blocks[NB_THREADS];
     } partition;
     struct 
     {
@@ -77,9 +108,12 @@ struct task_stack
 {
   unsigned int size;
   task_stack_node_t *nodes;
-  volatile unsigned int next_node;
+  // Tasks are reserved and pushed by any worker
+  volatile unsigned int next_node PADDED;
 
-  task_stack_node_t *head;
+  task_stack_node_t *head PADDED;
+  // Workers waiting for tasks
+  struct park park PADDED;
 };
 typedef struct task_stack task_stack_t;
 
@@ -90,6 +124,14 @@ task_t*   task_stack_reserve(task_stack_t* stack);
 
 void      task_stack_push(task_stack_t* stack, task_t* task);
 int       task_stack_pop(task_stack_t* stack, task_t** task);
+// Pop, sleeping up to timeout_us microseconds until a task is pushed.
+// Returns 0 with a task, -1 if none came in time, or 1 if
+// task_stack_wake_all() was called since this call began.
+int       task_stack_pop_wait(task_stack_t* stack, task_t** task, long timeout_us);
+void      task_stack_wake_all(task_stack_t* stack);
+
+// Operations and retries in CAS loops of the calling thread so far
+void      task_stack_backoff_stats(struct backoff_stats *stats);
 
 
 #endif /* TASK_H */
@@ -24,6 +24,7 @@
 #include <stdlib.h>
 #include <time.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "array.h"
 
@@ -46,7 +47,7 @@ main(int argc, char ** argv)
 
 	if(argc < 4)
 	{
-		printf("Usage: %s <min_value> <max_value> <number of values>\n", argv[0]);
+		printf("Usage: %s <min_value> <max_value> <number of values> [binary|ascii]\n", argv[0]);
 		return EXIT_FAILURE;
 	}
 	else
@@ -66,10 +67,10 @@ main(int argc, char ** argv)
 			array_put(array, random() % amplitude + min);
 		}
 
-		printf("%d ", count);
-		for(i = 0; i < count; i++)
+		if(array_fwrite(array, stdout, argc > 4 && strcmp(argv[4], "ascii") == 0 ? ARRAY_ASCII : ARRAY_BINARY) != 0)
 		{
-			printf("%d ", array_get(array, i));
+			perror(argv[0]);
+			return EXIT_FAILURE;
 		}
 		
 		array_free(array);
@@ -66,6 +66,10 @@ main(int argc, char** argv)
 	array_init(argc, argv);
 
 	array = array_read(argv[1]);
+	if (array == NULL)
+	{
+		return EXIT_FAILURE;
+	}
 
 	// Keep a copy in memory for later verification
 	check = array_alloc(array->capacity);